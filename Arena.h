@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+// Bump-pointer arena. Memory is handed out from large blocks and only returned all at once by
+// release() or the destructor; deallocate() is a no-op.
+class arena {
+public:
+    explicit arena(size_t block_size = 64 * 1024) : block_size_(block_size) {
+    }
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() {
+        release();
+    }
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        char* ptr = align(cur_, alignment);
+        if (ptr == nullptr || ptr > end_ || static_cast<size_t>(end_ - ptr) < bytes) {
+            if (bytes > std::numeric_limits<size_t>::max() - alignment - sizeof(block)) {
+                throw std::bad_alloc();
+            }
+            add_block(bytes + alignment);
+            ptr = align(cur_, alignment);
+        }
+        cur_ = ptr + bytes;
+        used_ += bytes;
+        return ptr;
+    }
+
+    void deallocate(void*, size_t) {
+    }
+
+    void release() {
+        while (head_ != nullptr) {
+            block* next = head_->next;
+            ::operator delete(head_);
+            head_ = next;
+        }
+        cur_ = nullptr;
+        end_ = nullptr;
+        used_ = 0;
+        reserved_ = 0;
+    }
+
+    size_t used() const {
+        return used_;
+    }
+
+    size_t reserved() const {
+        return reserved_;
+    }
+
+private:
+    struct block {
+        block* next;
+    };
+
+    static char* align(char* ptr, size_t alignment) {
+        if (ptr == nullptr) {
+            return nullptr;
+        }
+        uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+        return ptr + ((alignment - addr % alignment) % alignment);
+    }
+
+    void add_block(size_t min_bytes) {
+        size_t size = sizeof(block) + std::max(block_size_, min_bytes);
+        block* new_block = static_cast<block*>(::operator new(size));
+        new_block->next = head_;
+        head_ = new_block;
+        cur_ = reinterpret_cast<char*>(new_block + 1);
+        end_ = reinterpret_cast<char*>(new_block) + size;
+        reserved_ += size;
+    }
+
+    size_t block_size_;
+    block* head_ = nullptr;
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+    size_t used_ = 0;
+    size_t reserved_ = 0;
+};
+
+// Power-of-two size-class pool on top of an arena. my_vector grows by doubling, so the buffers it
+// frees are exactly the classes it asks for next; freed blocks are kept in per-class free lists
+// and reused instead of going back to malloc.
+class pool {
+public:
+    explicit pool(size_t block_size = 64 * 1024) : arena_(block_size) {
+    }
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        size_t cls = size_class(bytes);
+        if (alignment <= alignof(std::max_align_t) && free_[cls] != nullptr) {
+            node* res = free_[cls];
+            free_[cls] = res->next;
+            reused_++;
+            return res;
+        }
+        return arena_.allocate(size_t(1) << cls, std::max(alignment, alignof(std::max_align_t)));
+    }
+
+    void deallocate(void* ptr, size_t bytes) {
+        size_t cls = size_class(bytes);
+        node* freed = static_cast<node*>(ptr);
+        freed->next = free_[cls];
+        free_[cls] = freed;
+    }
+
+    void release() {
+        arena_.release();
+        for (node*& head : free_) {
+            head = nullptr;
+        }
+        reused_ = 0;
+    }
+
+    size_t reused() const {
+        return reused_;
+    }
+
+    const arena& upstream() const {
+        return arena_;
+    }
+
+private:
+    struct node {
+        node* next;
+    };
+
+    static constexpr size_t min_class_ = 4;
+    static constexpr size_t classes_ = std::numeric_limits<size_t>::digits;
+
+    static size_t size_class(size_t bytes) {
+        size_t cls = min_class_;
+        while (cls < classes_ && (size_t(1) << cls) < bytes) {
+            cls++;
+        }
+        if (cls == classes_) {
+            throw std::bad_alloc();
+        }
+        return cls;
+    }
+
+    arena arena_;
+    node* free_[classes_] = {};
+    size_t reused_ = 0;
+};
+
+template <class T, class Resource>
+class resource_allocator {
+public:
+    using value_type = T;
+
+    resource_allocator(Resource& resource) : resource_(&resource) {
+    }
+
+    template <class U>
+    resource_allocator(const resource_allocator<U, Resource>& anoth) : resource_(anoth.resource()) {
+    }
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        resource_->deallocate(ptr, n * sizeof(T));
+    }
+
+    Resource* resource() const {
+        return resource_;
+    }
+
+    template <class U>
+    bool operator==(const resource_allocator<U, Resource>& anoth) const {
+        return resource_ == anoth.resource();
+    }
+
+    template <class U>
+    bool operator!=(const resource_allocator<U, Resource>& anoth) const {
+        return resource_ != anoth.resource();
+    }
+
+private:
+    Resource* resource_;
+};
+
+template <class T>
+using arena_allocator = resource_allocator<T, arena>;
+
+template <class T>
+using pool_allocator = resource_allocator<T, pool>;
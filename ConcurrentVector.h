@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Append-only vector for many producer threads. Elements live in segments of B, 2B, 4B, ...
+// slots that are never moved, so references stay valid while the vector grows. push_back,
+// emplace_back and grow_by claim slots with one atomic add and install missing segments with a
+// CAS, so they never block; operator[] is wait-free.
+//
+// size() counts claimed slots. Another thread may read an element once it synchronizes with the
+// thread that appended it (e.g. by joining it or receiving the index through an atomic). A slot
+// whose constructor threw stays claimed but empty; it must not be read and is skipped on
+// destruction. The allocator must be safe to call from several threads. clear(), reserve() and
+// destruction must not run concurrently with anything else.
+template <class T, class Allocator = std::allocator<T>>
+class concurrent_vector {
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    static constexpr size_t first_block_ = std::bit_ceil(std::max<size_t>(8, 512 / sizeof(T)));
+    static constexpr size_t first_bits_ = std::countr_zero(first_block_);
+    static constexpr size_t segments_count_ = std::numeric_limits<size_t>::digits - first_bits_;
+
+public:
+    template <class Value>
+    class basic_iterator {
+        using owner = std::conditional_t<std::is_const_v<Value>, const concurrent_vector,
+                                         concurrent_vector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        basic_iterator() = default;
+
+        basic_iterator(owner* obj, size_t ind) : obj_(obj), ind_(ind) {
+        }
+
+        template <class Other>
+        requires(std::is_const_v<Value> && !std::is_const_v<Other>)
+        basic_iterator(const basic_iterator<Other>& anoth)
+            : obj_(anoth.owner_ptr()), ind_(anoth.index()) {
+        }
+
+        reference operator*() const {
+            return (*obj_)[ind_];
+        }
+
+        pointer operator->() const {
+            return &(*obj_)[ind_];
+        }
+
+        reference operator[](difference_type diff) const {
+            return (*obj_)[ind_ + diff];
+        }
+
+        basic_iterator& operator+=(difference_type diff) {
+            ind_ += diff;
+            return *this;
+        }
+
+        basic_iterator& operator-=(difference_type diff) {
+            ind_ -= diff;
+            return *this;
+        }
+
+        basic_iterator operator+(difference_type diff) const {
+            return basic_iterator(obj_, ind_ + diff);
+        }
+
+        friend basic_iterator operator+(difference_type diff, const basic_iterator& it) {
+            return it + diff;
+        }
+
+        basic_iterator operator-(difference_type diff) const {
+            return basic_iterator(obj_, ind_ - diff);
+        }
+
+        difference_type operator-(const basic_iterator& anoth) const {
+            return static_cast<difference_type>(ind_) - static_cast<difference_type>(anoth.ind_);
+        }
+
+        basic_iterator& operator++() {
+            ind_++;
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator res = *this;
+            ind_++;
+            return res;
+        }
+
+        basic_iterator& operator--() {
+            ind_--;
+            return *this;
+        }
+
+        basic_iterator operator--(int) {
+            basic_iterator res = *this;
+            ind_--;
+            return res;
+        }
+
+        bool operator==(const basic_iterator& anoth) const {
+            return ind_ == anoth.ind_;
+        }
+
+        std::strong_ordering operator<=>(const basic_iterator& anoth) const {
+            return ind_ <=> anoth.ind_;
+        }
+
+        owner* owner_ptr() const {
+            return obj_;
+        }
+
+        size_t index() const {
+            return ind_;
+        }
+
+    private:
+        owner* obj_ = nullptr;
+        size_t ind_ = 0;
+    };
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using iterator = basic_iterator<T>;
+    using const_iterator = basic_iterator<const T>;
+
+    concurrent_vector() {
+    }
+
+    explicit concurrent_vector(const Allocator& alloc) : alloc_(alloc) {
+    }
+
+    concurrent_vector(const concurrent_vector&) = delete;
+    concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+    ~concurrent_vector() {
+        clear();
+    }
+
+    T& push_back(const T& val) {
+        return emplace_back(val);
+    }
+
+    T& push_back(T&& val) {
+        return emplace_back(std::move(val));
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        size_t ind = size_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            T* slot = claim(ind);
+            alloc_traits::construct(alloc_, slot, std::forward<Args>(args)...);
+            return *slot;
+        } catch (...) {
+            mark_broken(ind, ind + 1);
+            throw;
+        }
+    }
+
+    // Appends count copies of val as one contiguous index range and returns its first index.
+    size_t grow_by(size_t count, const T& val = T()) {
+        size_t first = size_.fetch_add(count, std::memory_order_relaxed);
+        size_t ind = first;
+        try {
+            for (; ind < first + count; ++ind) {
+                alloc_traits::construct(alloc_, claim(ind), val);
+            }
+        } catch (...) {
+            mark_broken(ind, first + count);
+            throw;
+        }
+        return first;
+    }
+
+    // Installs the segments for the first new_capacity slots up front.
+    void reserve(size_t new_capacity) {
+        if (new_capacity != 0) {
+            for (size_t seg = 0; seg <= segment_of(new_capacity - 1); ++seg) {
+                segment(seg);
+            }
+        }
+    }
+
+    T& operator[](size_t ind) {
+        return segments_[segment_of(ind)].load(std::memory_order_acquire)[offset_of(ind)];
+    }
+
+    const T& operator[](size_t ind) const {
+        return segments_[segment_of(ind)].load(std::memory_order_acquire)[offset_of(ind)];
+    }
+
+    T& at(size_t ind) {
+        if (ind >= size()) {
+            throw std::out_of_range("concurrent_vector::at");
+        }
+        return (*this)[ind];
+    }
+
+    const T& at(size_t ind) const {
+        if (ind >= size()) {
+            throw std::out_of_range("concurrent_vector::at");
+        }
+        return (*this)[ind];
+    }
+
+    size_t size() const {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, size());
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    void clear() {
+        std::sort(broken_.begin(), broken_.end());
+        size_t size = size_.load(std::memory_order_relaxed);
+        size_t ind = 0;
+        for (auto [first, last] : broken_) {
+            destroy(ind, first);
+            ind = last;
+        }
+        destroy(ind, size);
+        broken_.clear();
+        for (size_t seg = 0; seg < segments_count_; ++seg) {
+            if (T* data = segments_[seg].exchange(nullptr)) {
+                alloc_traits::deallocate(alloc_, data, first_block_ << seg);
+            }
+        }
+        size_ = 0;
+    }
+
+private:
+    // Segment k holds indices [B * (2^k - 1), B * (2^(k + 1) - 1)).
+    static size_t segment_of(size_t ind) {
+        return std::bit_width((ind >> first_bits_) + 1) - 1;
+    }
+
+    static size_t offset_of(size_t ind) {
+        return ind - (first_block_ << segment_of(ind)) + first_block_;
+    }
+
+    T* claim(size_t ind) {
+        size_t seg = segment_of(ind);
+        if (seg >= segments_count_) {
+            throw std::length_error("concurrent_vector: too many elements");
+        }
+        return segment(seg) + offset_of(ind);
+    }
+
+    // Returns segment seg, allocating it if needed. Racing threads each allocate and the loser
+    // of the CAS frees its copy.
+    T* segment(size_t seg) {
+        T* data = segments_[seg].load(std::memory_order_acquire);
+        if (data != nullptr) {
+            return data;
+        }
+        T* fresh = alloc_traits::allocate(alloc_, first_block_ << seg);
+        if (segments_[seg].compare_exchange_strong(data, fresh, std::memory_order_acq_rel)) {
+            return fresh;
+        }
+        alloc_traits::deallocate(alloc_, fresh, first_block_ << seg);
+        return data;
+    }
+
+    void mark_broken(size_t first, size_t last) {
+        std::lock_guard<std::mutex> lock(broken_mutex_);
+        broken_.emplace_back(first, last);
+    }
+
+    void destroy(size_t first, size_t last) {
+        for (; first < last; ++first) {
+            alloc_traits::destroy(alloc_, &(*this)[first]);
+        }
+    }
+
+    [[no_unique_address]] Allocator alloc_;
+    std::atomic<size_t> size_ = 0;
+    std::atomic<T*> segments_[segments_count_] = {};
+    std::mutex broken_mutex_;
+    std::vector<std::pair<size_t, size_t>> broken_;
+};
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "Vector.h"
+
+// Copy-on-write vector: copies share one reference-counted my_vector, so a snapshot costs an
+// atomic increment, and the buffer is cloned on the first mutation of a shared copy. Like
+// std::shared_ptr, distinct cow_vector objects sharing a buffer may be used from different
+// threads; one object must not be used from several threads while one of them mutates it.
+//
+// Mutable element access (non-const operator[], at, front, back, data, begin, end) clones a
+// shared buffer and marks this vector as exposed: references handed out could write to a buffer
+// that a later copy would share, so copies of an exposed vector are deep. insert and erase
+// return const_iterators for the same reason. Read through a const reference, or cbegin/cend,
+// to keep snapshots O(1).
+template <class T, class Allocator = std::allocator<T>>
+class cow_vector {
+    using items_type = my_vector<T, Allocator>;
+
+    struct shared_block {
+        template <class... Args>
+        explicit shared_block(Args&&... args) : items(std::forward<Args>(args)...) {
+        }
+
+        std::atomic<size_t> refs = 1;
+        items_type items;
+    };
+
+    using block_alloc =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<shared_block>;
+    using block_traits = std::allocator_traits<block_alloc>;
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = typename items_type::iterator;
+    using const_iterator = typename items_type::const_iterator;
+
+    cow_vector() {
+    }
+
+    explicit cow_vector(const Allocator& alloc) : alloc_(alloc) {
+    }
+
+    cow_vector(size_t size, const T& val = T(), const Allocator& alloc = Allocator())
+        : alloc_(alloc), block_(make_block(alloc, size, val, alloc)) {
+    }
+
+    cow_vector(std::initializer_list<T> list, const Allocator& alloc = Allocator())
+        : alloc_(alloc), block_(make_block(alloc, list, alloc)) {
+    }
+
+    template <std::input_iterator It>
+    cow_vector(It first, It last, const Allocator& alloc = Allocator())
+        : alloc_(alloc), block_(make_block(alloc, first, last, alloc)) {
+    }
+
+    // Takes over the buffer of items without copying.
+    explicit cow_vector(items_type&& items)
+        : alloc_(items.get_allocator()), block_(make_block(alloc_, std::move(items))) {
+    }
+
+    cow_vector(const cow_vector& anoth)
+        : alloc_(alloc_traits::select_on_container_copy_construction(anoth.alloc_)),
+          block_(anoth.share(alloc_)) {
+    }
+
+    cow_vector(cow_vector&& anoth) noexcept
+        : alloc_(anoth.alloc_),
+          block_(std::exchange(anoth.block_, nullptr)),
+          exposed_(std::exchange(anoth.exposed_, false)) {
+    }
+
+    cow_vector& operator=(const cow_vector& anoth) {
+        if (this != &anoth) {
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                alloc_ = anoth.alloc_;
+            }
+            shared_block* block = anoth.share(alloc_);
+            release();
+            block_ = block;
+            exposed_ = false;
+        }
+        return *this;
+    }
+
+    cow_vector& operator=(cow_vector&& anoth) noexcept {
+        if (this != &anoth) {
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                alloc_ = anoth.alloc_;
+            }
+            release();
+            block_ = std::exchange(anoth.block_, nullptr);
+            exposed_ = std::exchange(anoth.exposed_, false);
+        }
+        return *this;
+    }
+
+    ~cow_vector() {
+        release();
+    }
+
+    void push_back(const T& val) {
+        emplace_back(val);
+    }
+
+    void push_back(T&& val) {
+        emplace_back(std::move(val));
+    }
+
+    // When the buffer is shared the value is built before cloning: once this vector drops its
+    // reference, another owner may free the buffer that the arguments refer into.
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        if (is_shared()) {
+            T val(std::forward<Args>(args)...);
+            mutate().push_back(std::move(val));
+        } else {
+            mutate().emplace_back(std::forward<Args>(args)...);
+        }
+    }
+
+    void pop_back() {
+        if (empty()) {
+            throw std::exception();
+        }
+        mutate().pop_back();
+    }
+
+    const_iterator insert(const_iterator it, const T& val) {
+        return emplace(it, val);
+    }
+
+    const_iterator insert(const_iterator it, T&& val) {
+        return emplace(it, std::move(val));
+    }
+
+    template <class... Args>
+    const_iterator emplace(const_iterator it, Args&&... args) {
+        size_t ind = index_of(it);
+        if (is_shared()) {
+            T val(std::forward<Args>(args)...);
+            items_type& items = mutate();
+            items.insert(items.begin() + ind, std::move(val));
+        } else {
+            items_type& items = mutate();
+            items.emplace(items.begin() + ind, std::forward<Args>(args)...);
+        }
+        return iterator_at(ind);
+    }
+
+    const_iterator erase(const_iterator it) {
+        return erase(it, it + 1);
+    }
+
+    const_iterator erase(const_iterator first, const_iterator last) {
+        size_t from = index_of(first);
+        size_t to = index_of(last);
+        if (from != to) {
+            items_type& items = mutate();
+            items.erase(items.begin() + from, items.begin() + to);
+        }
+        return iterator_at(from);
+    }
+
+    void resize(size_t new_size) {
+        if (new_size != size()) {
+            mutate().resize(new_size);
+        }
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity > capacity()) {
+            mutate().reserve(new_capacity);
+        }
+    }
+
+    // Drops this vector's reference; other copies keep their elements.
+    void clear() {
+        release();
+        exposed_ = false;
+    }
+
+    T& operator[](size_t ind) {
+        return expose()[ind];
+    }
+
+    const T& operator[](size_t ind) const {
+        return block_->items[ind];
+    }
+
+    T& at(size_t ind) {
+        if (ind >= size()) {
+            throw std::out_of_range("cow_vector::at");
+        }
+        return expose()[ind];
+    }
+
+    const T& at(size_t ind) const {
+        if (ind >= size()) {
+            throw std::out_of_range("cow_vector::at");
+        }
+        return block_->items[ind];
+    }
+
+    T& front() {
+        return expose().front();
+    }
+
+    const T& front() const {
+        return block_->items.front();
+    }
+
+    T& back() {
+        return expose().back();
+    }
+
+    const T& back() const {
+        return block_->items.back();
+    }
+
+    T* data() {
+        return expose().data();
+    }
+
+    const T* data() const {
+        return block_ != nullptr ? block_->items.data() : nullptr;
+    }
+
+    iterator begin() {
+        return expose().begin();
+    }
+
+    iterator end() {
+        return expose().end();
+    }
+
+    const_iterator begin() const {
+        return iterator_at(0);
+    }
+
+    const_iterator end() const {
+        return iterator_at(size());
+    }
+
+    const_iterator cbegin() const {
+        return begin();
+    }
+
+    const_iterator cend() const {
+        return end();
+    }
+
+    size_t size() const {
+        return block_ != nullptr ? block_->items.size() : 0;
+    }
+
+    size_t capacity() const {
+        return block_ != nullptr ? block_->items.capacity() : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    // Number of cow_vectors sharing the buffer; 0 for a vector without one.
+    size_t use_count() const {
+        return block_ != nullptr ? block_->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+    // The shared elements, without cloning.
+    std::span<const T> view() const {
+        return {data(), size()};
+    }
+
+    Allocator get_allocator() const {
+        return alloc_;
+    }
+
+    // Blocks carry their own allocator, so they can change hands even when the allocators stay.
+    void swap(cow_vector& anoth) {
+        if constexpr (alloc_traits::propagate_on_container_swap::value) {
+            std::swap(alloc_, anoth.alloc_);
+        }
+        std::swap(block_, anoth.block_);
+        std::swap(exposed_, anoth.exposed_);
+    }
+
+    bool operator==(const cow_vector& anoth) const {
+        if (block_ == anoth.block_) {
+            return true;
+        }
+        if (block_ == nullptr || anoth.block_ == nullptr) {
+            return empty() && anoth.empty();
+        }
+        return block_->items == anoth.block_->items;
+    }
+
+    bool operator!=(const cow_vector& anoth) const {
+        return !(*this == anoth);
+    }
+
+private:
+    // A vector without a block is empty; its iterators are value-initialized.
+    const_iterator iterator_at(size_t ind) const {
+        return block_ != nullptr ? block_->items.begin() + ind : const_iterator();
+    }
+
+    bool is_shared() const {
+        return block_ != nullptr && block_->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    // The buffer for a copy: the same block with one more reference, or a deep copy made with
+    // alloc if this vector has handed out mutable references.
+    shared_block* share(const Allocator& alloc) const {
+        if (block_ == nullptr) {
+            return nullptr;
+        }
+        if (exposed_) {
+            return make_block(alloc, block_->items, alloc);
+        }
+        block_->refs.fetch_add(1, std::memory_order_relaxed);
+        return block_;
+    }
+
+    // Makes the buffer unshared, cloning it if other vectors hold it, and returns it.
+    items_type& mutate() {
+        if (block_ == nullptr) {
+            block_ = make_block(alloc_, alloc_);
+        } else if (is_shared()) {
+            shared_block* copy = make_block(alloc_, block_->items, alloc_);
+            release();
+            block_ = copy;
+        }
+        return block_->items;
+    }
+
+    items_type& expose() {
+        items_type& items = mutate();
+        exposed_ = true;
+        return items;
+    }
+
+    size_t index_of(const_iterator it) const {
+        return it - begin();
+    }
+
+    // The block is allocated with the allocator its items are built with; release() relies on it.
+    template <class... Args>
+    static shared_block* make_block(const Allocator& items_alloc, Args&&... args) {
+        block_alloc alloc(items_alloc);
+        shared_block* block = block_traits::allocate(alloc, 1);
+        try {
+            block_traits::construct(alloc, block, std::forward<Args>(args)...);
+        } catch (...) {
+            block_traits::deallocate(alloc, block, 1);
+            throw;
+        }
+        return block;
+    }
+
+    // The last owner frees the block; acq_rel makes the other owners' reads happen before it.
+    // Assignment can leave this vector holding a block made by another allocator, so the block is
+    // freed through the allocator of its items, which is always the one that made it.
+    void release() {
+        if (block_ != nullptr && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            block_alloc alloc(block_->items.get_allocator());
+            block_traits::destroy(alloc, block_);
+            block_traits::deallocate(alloc, block_, 1);
+        }
+        block_ = nullptr;
+    }
+
+    [[no_unique_address]] Allocator alloc_;
+    shared_block* block_ = nullptr;
+    bool exposed_ = false;
+};
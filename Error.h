@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <stdexcept>
+
+// Error reporting of my_vector. By default failures throw: std::bad_alloc, std::length_error,
+// std::out_of_range, or a bare std::exception for misuse such as pop_back() on an empty vector.
+// Defining MY_VECTOR_NO_EXCEPTIONS, or compiling with -fno-exceptions, removes every throw and
+// try block from Vector.h; failures then call the handler and abort, and the mutators and try_
+// functions are noexcept whenever T's constructors and moves are. try_reserve() and
+// try_push_back() report allocation failure as a status in both modes.
+#if defined(MY_VECTOR_NO_EXCEPTIONS) || !defined(__cpp_exceptions)
+#define MY_VECTOR_EXCEPTIONS 0
+#define MY_VECTOR_TRY if (true)
+#define MY_VECTOR_CATCH_ALL if (false)
+#define MY_VECTOR_RETHROW
+#else
+#define MY_VECTOR_EXCEPTIONS 1
+#define MY_VECTOR_TRY try
+#define MY_VECTOR_CATCH_ALL catch (...)
+#define MY_VECTOR_RETHROW throw
+#endif
+
+inline constexpr bool vector_exceptions = MY_VECTOR_EXCEPTIONS;
+
+enum class [[nodiscard]] vector_status {
+    ok,
+    out_of_memory,
+    length_error,
+    out_of_range,
+    precondition,
+};
+
+inline const char* vector_status_name(vector_status status) {
+    switch (status) {
+        case vector_status::ok:
+            return "ok";
+        case vector_status::out_of_memory:
+            return "out of memory";
+        case vector_status::length_error:
+            return "too many elements";
+        case vector_status::out_of_range:
+            return "index out of range";
+        case vector_status::precondition:
+            return "precondition violated";
+    }
+    return "unknown error";
+}
+
+// Called with the failure and the function it happened in before the default action. It may
+// throw its own exception (when exceptions are enabled), log, or end the program; if it returns,
+// the default action follows.
+using vector_error_handler = void (*)(vector_status status, const char* where);
+
+inline std::atomic<vector_error_handler> vector_handler = nullptr;
+
+// Installs handler for all my_vectors and returns the previous one; nullptr restores the default.
+inline vector_error_handler set_vector_error_handler(vector_error_handler handler) {
+    return vector_handler.exchange(handler);
+}
+
+[[noreturn]] inline void vector_fail(vector_status status, const char* where) {
+    if (vector_error_handler handler = vector_handler.load(std::memory_order_relaxed)) {
+        handler(status, where);
+    }
+#if MY_VECTOR_EXCEPTIONS
+    switch (status) {
+        case vector_status::out_of_memory:
+            throw std::bad_alloc();
+        case vector_status::length_error:
+            throw std::length_error(where);
+        case vector_status::out_of_range:
+            throw std::out_of_range(where);
+        default:
+            throw std::exception();
+    }
+#else
+    std::fprintf(stderr, "%s: %s\n", where, vector_status_name(status));
+    std::abort();
+#endif
+}
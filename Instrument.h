@@ -0,0 +1,129 @@
+#pragma once
+
+// Opt-in allocation instrumentation for my_vector, enabled by defining MY_VECTOR_INSTRUMENT.
+// Without it this header declares nothing and my_vector carries no counters or hook calls.
+#ifdef MY_VECTOR_INSTRUMENT
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdio>
+
+enum class vector_event { reallocate, clear, destroy };
+
+// Passed to the hook. Capacities are in elements; the size is the one before the event.
+struct vector_event_info {
+    vector_event event;
+    const void* vector;
+    size_t element_size;
+    size_t size;
+    size_t old_capacity;
+    size_t new_capacity;
+    size_t bytes_moved;
+};
+
+using vector_hook = void (*)(const vector_event_info&);
+
+// Counters of one my_vector, see my_vector::stats(). Copies and moves start from zero.
+struct vector_stats {
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    size_t reallocations = 0;
+    size_t bytes_moved = 0;
+    size_t constructions = 0;
+    size_t peak_capacity = 0;
+};
+
+// The same counters summed over all vectors, the hook, and a histogram of (size, capacity) at
+// destruction bucketed by powers of two of the size. All members are safe to use concurrently.
+class vector_instrument {
+public:
+    static constexpr size_t buckets_ = 65;
+
+    std::atomic<size_t> allocations = 0;
+    std::atomic<size_t> deallocations = 0;
+    std::atomic<size_t> reallocations = 0;
+    std::atomic<size_t> bytes_moved = 0;
+    std::atomic<size_t> constructions = 0;
+    std::atomic<size_t> peak_capacity_bytes = 0;
+
+    static vector_instrument& global() {
+        static vector_instrument instance;
+        return instance;
+    }
+
+    void set_hook(vector_hook hook) {
+        hook_ = hook;
+    }
+
+    void fire(const vector_event_info& info) {
+        if (vector_hook hook = hook_.load(std::memory_order_relaxed)) {
+            hook(info);
+        }
+        if (info.event == vector_event::destroy) {
+            bucket& row = histogram_[std::bit_width(info.size)];
+            row.vectors.fetch_add(1, std::memory_order_relaxed);
+            row.size_sum.fetch_add(info.size, std::memory_order_relaxed);
+            row.capacity_sum.fetch_add(info.old_capacity, std::memory_order_relaxed);
+            row.slack_bytes.fetch_add((info.old_capacity - info.size) * info.element_size,
+                                      std::memory_order_relaxed);
+        }
+    }
+
+    void note_capacity(size_t bytes) {
+        size_t peak = peak_capacity_bytes.load(std::memory_order_relaxed);
+        while (bytes > peak && !peak_capacity_bytes.compare_exchange_weak(peak, bytes)) {
+        }
+    }
+
+    // Prints one row per size range: how many vectors died with that size, their average size
+    // and capacity, and the unused capacity they held. A reserve() of the typical size avoids
+    // the reallocations that led to the capacity.
+    void dump_histogram(std::FILE* out = stderr) const {
+        std::fprintf(out, "%-24s %10s %12s %12s %14s\n", "final size", "vectors", "avg size",
+                     "avg capacity", "slack bytes");
+        for (size_t b = 0; b < buckets_; ++b) {
+            const bucket& row = histogram_[b];
+            size_t vectors = row.vectors.load();
+            if (vectors == 0) {
+                continue;
+            }
+            size_t low = b == 0 ? 0 : size_t(1) << (b - 1);
+            size_t high = b == 0 ? 0 : (size_t(1) << (b - 1)) * 2 - 1;
+            char range[32];
+            std::snprintf(range, sizeof(range), "%zu..%zu", low, high);
+            std::fprintf(out, "%-24s %10zu %12.1f %12.1f %14zu\n", range, vectors,
+                         static_cast<double>(row.size_sum.load()) / vectors,
+                         static_cast<double>(row.capacity_sum.load()) / vectors,
+                         row.slack_bytes.load());
+        }
+    }
+
+    void reset() {
+        allocations = 0;
+        deallocations = 0;
+        reallocations = 0;
+        bytes_moved = 0;
+        constructions = 0;
+        peak_capacity_bytes = 0;
+        for (bucket& row : histogram_) {
+            row.vectors = 0;
+            row.size_sum = 0;
+            row.capacity_sum = 0;
+            row.slack_bytes = 0;
+        }
+    }
+
+private:
+    struct bucket {
+        std::atomic<size_t> vectors = 0;
+        std::atomic<size_t> size_sum = 0;
+        std::atomic<size_t> capacity_sum = 0;
+        std::atomic<size_t> slack_bytes = 0;
+    };
+
+    std::atomic<vector_hook> hook_ = nullptr;
+    bucket histogram_[buckets_];
+};
+
+#endif
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// Allocator for large vectors of trivially relocatable data. Buffers of at least Threshold bytes
+// are anonymous mappings that grow with mremap(MREMAP_MAYMOVE), so my_vector's growth becomes a
+// page-table update instead of a copy; smaller buffers live in malloc and grow with realloc.
+template <class T, size_t Threshold = 1 << 20>
+class mmap_allocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+
+public:
+    using value_type = T;
+
+    mmap_allocator() = default;
+
+    template <class U>
+    mmap_allocator(const mmap_allocator<U, Threshold>&) {
+    }
+
+    template <class U>
+    struct rebind {
+        using other = mmap_allocator<U, Threshold>;
+    };
+
+    T* allocate(size_t n) {
+        size_t bytes = checked_bytes(n);
+        if (!is_mapped(bytes)) {
+            return static_cast<T*>(check(std::malloc(bytes)));
+        }
+        void* ptr = mmap(nullptr, page_round(bytes), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return static_cast<T*>(check(ptr == MAP_FAILED ? nullptr : ptr));
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (!is_mapped(bytes)) {
+            std::free(ptr);
+        } else {
+            munmap(ptr, page_round(bytes));
+        }
+    }
+
+    // Resizes the buffer keeping its first min(old_n, new_n) elements. On failure throws
+    // std::bad_alloc and leaves the old buffer untouched.
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+        size_t old_bytes = old_n * sizeof(T);
+        size_t new_bytes = checked_bytes(new_n);
+        if (!is_mapped(old_bytes) && !is_mapped(new_bytes)) {
+            return static_cast<T*>(check(std::realloc(static_cast<void*>(ptr), new_bytes)));
+        }
+        if (is_mapped(old_bytes) && is_mapped(new_bytes)) {
+            return remap(ptr, old_bytes, new_bytes);
+        }
+        T* res = allocate(new_n);
+        std::memcpy(static_cast<void*>(res), static_cast<void*>(ptr),
+                    std::min(old_bytes, new_bytes));
+        deallocate(ptr, old_n);
+        return res;
+    }
+
+    bool operator==(const mmap_allocator&) const {
+        return true;
+    }
+
+    bool operator!=(const mmap_allocator&) const {
+        return false;
+    }
+
+private:
+    static bool is_mapped(size_t bytes) {
+        return bytes >= Threshold;
+    }
+
+    static size_t page_round(size_t bytes) {
+        static const size_t page = sysconf(_SC_PAGESIZE);
+        return (bytes + page - 1) / page * page;
+    }
+
+    static size_t checked_bytes(size_t n) {
+        if (n > (static_cast<size_t>(-1) >> 1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return n * sizeof(T);
+    }
+
+    static void* check(void* ptr) {
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    static T* remap(T* ptr, size_t old_bytes, size_t new_bytes) {
+        size_t old_size = page_round(old_bytes);
+        size_t new_size = page_round(new_bytes);
+        if (old_size == new_size) {
+            return ptr;
+        }
+#ifdef __linux__
+        void* res = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+        return static_cast<T*>(check(res == MAP_FAILED ? nullptr : res));
+#else
+        void* res = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1, 0);
+        check(res == MAP_FAILED ? nullptr : res);
+        std::memcpy(res, ptr, std::min(old_size, new_size));
+        munmap(ptr, old_size);
+        return static_cast<T*>(res);
+#endif
+    }
+};
+
+enum class numa_mode { none, interleave, bind };
+
+// Placement for huge_page_allocator mappings. nodes is a bit mask of NUMA node ids; with hugetlb
+// set, MAP_HUGETLB pages from the reserved pool are tried before transparent huge pages.
+struct huge_page_options {
+    numa_mode numa = numa_mode::none;
+    unsigned long nodes = 0;
+    bool hugetlb = false;
+
+    bool operator==(const huge_page_options&) const = default;
+};
+
+// Process-wide counters of huge_page_allocator. The byte counters track live allocations; the
+// failure counters count allocations that fell back because the kernel refused a hint.
+struct huge_page_counters {
+    std::atomic<size_t> mapped_bytes = 0;
+    std::atomic<size_t> heap_bytes = 0;
+    std::atomic<size_t> hugetlb_mappings = 0;
+    std::atomic<size_t> advise_failures = 0;
+    std::atomic<size_t> numa_failures = 0;
+};
+
+inline huge_page_counters& huge_page_stats() {
+    static huge_page_counters counters;
+    return counters;
+}
+
+// Bytes of this process's anonymous memory currently backed by transparent huge pages, from
+// /proc/self/smaps_rollup; 0 where that is unavailable.
+inline size_t anon_huge_page_bytes() {
+    size_t kib = 0;
+#ifdef __linux__
+    if (std::FILE* file = std::fopen("/proc/self/smaps_rollup", "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof(line), file) != nullptr) {
+            if (std::sscanf(line, "AnonHugePages: %zu kB", &kib) == 1) {
+                break;
+            }
+        }
+        std::fclose(file);
+    }
+#endif
+    return kib << 10;
+}
+
+// Allocator for large, randomly accessed vectors. Buffers of at least Threshold bytes are mapped
+// on 2 MiB boundaries and advised as huge pages (or taken from the hugetlb pool), cutting TLB
+// misses, and are optionally bound or interleaved across NUMA nodes. Smaller buffers come from
+// the heap. Every buffer is aligned to Alignment bytes. Huge pages and NUMA placement are hints:
+// when the kernel refuses them the allocation still succeeds and the failure is counted in
+// huge_page_stats().
+template <class T, size_t Alignment = 64, size_t Threshold = size_t(2) << 20>
+class huge_page_allocator {
+    static constexpr size_t huge_page_size_ = size_t(2) << 20;
+
+    static_assert(std::has_single_bit(Alignment) && Alignment >= alignof(T),
+                  "Alignment must be a power of two no smaller than alignof(T)");
+    static_assert(Alignment <= huge_page_size_, "Alignment above 2 MiB is not supported");
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    huge_page_allocator() = default;
+
+    explicit huge_page_allocator(huge_page_options options) : options_(options) {
+    }
+
+    template <class U>
+    huge_page_allocator(const huge_page_allocator<U, Alignment, Threshold>& anoth)
+        : options_(anoth.options()) {
+    }
+
+    template <class U>
+    struct rebind {
+        using other = huge_page_allocator<U, Alignment, Threshold>;
+    };
+
+    T* allocate(size_t n) {
+        size_t bytes = checked_bytes(n);
+        if (!is_mapped(bytes)) {
+            T* res = static_cast<T*>(::operator new(bytes, std::align_val_t(Alignment)));
+            huge_page_stats().heap_bytes += bytes;
+            return res;
+        }
+        size_t size = huge_round(bytes);
+        void* ptr = options_.hugetlb ? map_hugetlb(size) : nullptr;
+        if (ptr == nullptr) {
+            ptr = map_aligned(size);
+        }
+        place(ptr, size);
+        huge_page_stats().mapped_bytes += size;
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (!is_mapped(bytes)) {
+            ::operator delete(ptr, std::align_val_t(Alignment));
+            huge_page_stats().heap_bytes -= bytes;
+        } else {
+            munmap(ptr, huge_round(bytes));
+            huge_page_stats().mapped_bytes -= huge_round(bytes);
+        }
+    }
+
+    const huge_page_options& options() const {
+        return options_;
+    }
+
+    template <class U>
+    bool operator==(const huge_page_allocator<U, Alignment, Threshold>& anoth) const {
+        return options_ == anoth.options();
+    }
+
+private:
+    static bool is_mapped(size_t bytes) {
+        return bytes >= Threshold;
+    }
+
+    static size_t huge_round(size_t bytes) {
+        return (bytes + huge_page_size_ - 1) / huge_page_size_ * huge_page_size_;
+    }
+
+    static size_t checked_bytes(size_t n) {
+        if (n > (static_cast<size_t>(-1) >> 2) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return n * sizeof(T);
+    }
+
+    static void* map_hugetlb(size_t size) {
+#ifdef MAP_HUGETLB
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            huge_page_stats().hugetlb_mappings++;
+            return ptr;
+        }
+#endif
+        huge_page_stats().advise_failures++;
+        return nullptr;
+    }
+
+    // Over-maps by one huge page and trims both ends, leaving size bytes on a 2 MiB boundary so
+    // that the whole buffer can be backed by huge pages.
+    static void* map_aligned(size_t size) {
+        void* raw = mmap(nullptr, size + huge_page_size_, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char* begin = static_cast<char*>(raw);
+        size_t head = (huge_page_size_ - reinterpret_cast<uintptr_t>(begin) % huge_page_size_) %
+                      huge_page_size_;
+        if (head != 0) {
+            munmap(begin, head);
+        }
+        munmap(begin + head + size, huge_page_size_ - head);
+        begin += head;
+#ifdef MADV_HUGEPAGE
+        if (madvise(begin, size, MADV_HUGEPAGE) != 0) {
+            huge_page_stats().advise_failures++;
+        }
+#else
+        huge_page_stats().advise_failures++;
+#endif
+        return begin;
+    }
+
+    // Applies the NUMA policy before the first touch, so pages are placed as they fault in.
+    void place(void* ptr, size_t size) const {
+        if (options_.numa == numa_mode::none) {
+            return;
+        }
+#if defined(__linux__) && defined(SYS_mbind)
+        // MPOL_BIND and MPOL_INTERLEAVE from <linux/mempolicy.h>.
+        long mode = options_.numa == numa_mode::bind ? 2 : 3;
+        unsigned long nodes = options_.nodes;
+        if (syscall(SYS_mbind, ptr, size, mode, &nodes, sizeof(nodes) * 8 + 1, 0) == 0) {
+            return;
+        }
+#endif
+        huge_page_stats().numa_failures++;
+    }
+
+    huge_page_options options_;
+};
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Vector.h"
+
+// On-disk layout of an mmap_vector file: this header, then `capacity` elements. Its size keeps
+// the elements 64-byte aligned.
+struct mmap_vector_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t element_size;
+    uint64_t count;
+    uint64_t capacity;
+    unsigned char reserved[32];
+};
+
+static_assert(sizeof(mmap_vector_header) == 64);
+
+enum class mmap_mode { read_write, read_only };
+
+// Vector of trivially copyable elements stored in a file that is mapped MAP_SHARED, so opening
+// an existing table is one mmap call and changes reach the file (and other mappings of it)
+// without explicit writes. Growth extends the file and remaps it, which invalidates pointers into
+// the vector. flush() forces the pages to disk. A read_only vector throws on any mutation, and on
+// non-const element access since its pages cannot be written; read it through a const reference.
+// Files are tied to the build: they hold raw T bytes and are only checked for sizeof(T).
+template <class T, class GrowthPolicy = doubling_growth>
+class mmap_vector {
+    static_assert(std::is_trivially_copyable_v<T>, "mmap_vector needs trivially copyable T");
+    static_assert(alignof(T) <= sizeof(mmap_vector_header), "over-aligned types are not supported");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr uint64_t magic_ = 0x524f544345564d4d;  // "MMVECTOR"
+    static constexpr uint32_t version_ = 1;
+
+    // Opens path, creating an empty vector there if the file does not exist or is empty (only in
+    // read_write mode). Throws std::system_error on I/O errors and std::runtime_error if the file
+    // is not an mmap_vector of T.
+    explicit mmap_vector(const std::string& path, mmap_mode mode = mmap_mode::read_write)
+        : read_only_(mode == mmap_mode::read_only) {
+        try {
+            open(path);
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    mmap_vector(const mmap_vector&) = delete;
+    mmap_vector& operator=(const mmap_vector&) = delete;
+
+    mmap_vector(mmap_vector&& anoth) noexcept
+        : fd_(std::exchange(anoth.fd_, -1)),
+          header_(std::exchange(anoth.header_, nullptr)),
+          mapped_(std::exchange(anoth.mapped_, 0)),
+          read_only_(anoth.read_only_) {
+    }
+
+    mmap_vector& operator=(mmap_vector&& anoth) noexcept {
+        if (this != &anoth) {
+            close();
+            fd_ = std::exchange(anoth.fd_, -1);
+            header_ = std::exchange(anoth.header_, nullptr);
+            mapped_ = std::exchange(anoth.mapped_, 0);
+            read_only_ = anoth.read_only_;
+        }
+        return *this;
+    }
+
+    ~mmap_vector() {
+        close();
+    }
+
+    void push_back(const T& val) {
+        T copy = val;
+        check_writable();
+        if (size() == capacity()) {
+            remap(GrowthPolicy::template next_capacity<T>(capacity(), size() + 1));
+        }
+        elements()[size()] = copy;
+        header_->count++;
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        push_back(T(std::forward<Args>(args)...));
+        return back();
+    }
+
+    void pop_back() {
+        check_writable();
+        if (empty()) {
+            throw std::exception();
+        }
+        header_->count--;
+    }
+
+    // New elements are value-initialized; the file may still hold bytes of erased ones.
+    void resize(size_t new_size) {
+        check_writable();
+        if (new_size > capacity()) {
+            remap(GrowthPolicy::template next_capacity<T>(capacity(), new_size));
+        }
+        if (new_size > size()) {
+            std::fill(elements() + size(), elements() + new_size, T());
+        }
+        header_->count = new_size;
+    }
+
+    void reserve(size_t new_capacity) {
+        check_writable();
+        if (new_capacity > capacity()) {
+            remap(new_capacity);
+        }
+    }
+
+    // Truncates the file to the elements in use.
+    void shrink_to_fit() {
+        check_writable();
+        if (capacity() != size()) {
+            remap(size());
+        }
+    }
+
+    void clear() {
+        check_writable();
+        header_->count = 0;
+    }
+
+    // Writes dirty pages back to the file and waits for the I/O.
+    void flush() {
+        if (!read_only_ && msync(header_, mapped_, MS_SYNC) != 0) {
+            fail("mmap_vector: msync");
+        }
+    }
+
+    T& operator[](size_t ind) {
+        return data()[ind];
+    }
+
+    const T& operator[](size_t ind) const {
+        return data()[ind];
+    }
+
+    T& at(size_t ind) {
+        if (ind >= size()) {
+            throw std::out_of_range("mmap_vector::at");
+        }
+        return data()[ind];
+    }
+
+    const T& at(size_t ind) const {
+        if (ind >= size()) {
+            throw std::out_of_range("mmap_vector::at");
+        }
+        return data()[ind];
+    }
+
+    T& front() {
+        return data()[0];
+    }
+
+    const T& front() const {
+        return data()[0];
+    }
+
+    T& back() {
+        return data()[size() - 1];
+    }
+
+    const T& back() const {
+        return data()[size() - 1];
+    }
+
+    T* data() {
+        check_writable();
+        return elements();
+    }
+
+    const T* data() const {
+        return reinterpret_cast<const T*>(header_ + 1);
+    }
+
+    size_t size() const {
+        return header_->count;
+    }
+
+    size_t capacity() const {
+        return header_->capacity;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    bool read_only() const {
+        return read_only_;
+    }
+
+    iterator begin() {
+        return data();
+    }
+
+    iterator end() {
+        return data() + size();
+    }
+
+    const_iterator begin() const {
+        return data();
+    }
+
+    const_iterator end() const {
+        return data() + size();
+    }
+
+private:
+    [[noreturn]] static void fail(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    static size_t file_bytes(size_t capacity) {
+        if (capacity > (static_cast<size_t>(-1) >> 1) / sizeof(T)) {
+            throw std::length_error("mmap_vector: too many elements");
+        }
+        return sizeof(mmap_vector_header) + capacity * sizeof(T);
+    }
+
+    T* elements() const {
+        return reinterpret_cast<T*>(header_ + 1);
+    }
+
+    void check_writable() const {
+        if (read_only_) {
+            throw std::exception();
+        }
+    }
+
+    void open(const std::string& path) {
+        fd_ = ::open(path.c_str(), read_only_ ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            fail("mmap_vector: open");
+        }
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            fail("mmap_vector: fstat");
+        }
+        size_t bytes = st.st_size;
+        if (bytes == 0 && !read_only_) {
+            if (ftruncate(fd_, sizeof(mmap_vector_header)) != 0) {
+                fail("mmap_vector: ftruncate");
+            }
+            map(sizeof(mmap_vector_header));
+            *header_ = {magic_, version_, sizeof(T), 0, 0, {}};
+            return;
+        }
+        if (bytes < sizeof(mmap_vector_header)) {
+            throw std::runtime_error("mmap_vector: file too short");
+        }
+        map(bytes);
+        if (header_->magic != magic_ || header_->version != version_) {
+            throw std::runtime_error("mmap_vector: not an mmap_vector file");
+        }
+        if (header_->element_size != sizeof(T) || header_->count > header_->capacity ||
+            header_->capacity > (bytes - sizeof(mmap_vector_header)) / sizeof(T)) {
+            throw std::runtime_error("mmap_vector: header does not match the file");
+        }
+    }
+
+    void map(size_t bytes) {
+        int prot = read_only_ ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* ptr = mmap(nullptr, bytes, prot, MAP_SHARED, fd_, 0);
+        if (ptr == MAP_FAILED) {
+            fail("mmap_vector: mmap");
+        }
+        header_ = static_cast<mmap_vector_header*>(ptr);
+        mapped_ = bytes;
+    }
+
+    // Resizes the file to hold new_capacity elements and maps all of it.
+    void remap(size_t new_capacity) {
+        size_t bytes = file_bytes(new_capacity);
+        if (ftruncate(fd_, bytes) != 0) {
+            fail("mmap_vector: ftruncate");
+        }
+#ifdef __linux__
+        void* ptr = mremap(header_, mapped_, bytes, MREMAP_MAYMOVE);
+        if (ptr == MAP_FAILED) {
+            fail("mmap_vector: mremap");
+        }
+        header_ = static_cast<mmap_vector_header*>(ptr);
+        mapped_ = bytes;
+#else
+        munmap(header_, mapped_);
+        header_ = nullptr;
+        map(bytes);
+#endif
+        header_->capacity = new_capacity;
+    }
+
+    void close() {
+        if (header_ != nullptr) {
+            munmap(header_, mapped_);
+            header_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    mmap_vector_header* header_ = nullptr;
+    size_t mapped_ = 0;
+    bool read_only_;
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Error.h"
+
+// Fork-join pool behind my_vector's parallel bulk operations. The calling thread works too, so a
+// pool of size() threads owns size() - 1 workers; they are started on first use. Calls made from
+// inside a running job execute serially instead of deadlocking.
+class thread_pool {
+public:
+    explicit thread_pool(size_t threads = std::thread::hardware_concurrency())
+        : threads_(std::max<size_t>(threads, 1)) {
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t size() const {
+        return threads_;
+    }
+
+    // Number of contiguous pieces for_chunks() splits n items into.
+    size_t parts(size_t n) const {
+        return std::min(threads_, n);
+    }
+
+    // Calls f(first, last) for each piece of [0, n) in parallel and returns once all are done.
+    // Rethrows the first exception thrown by f; the other pieces still run to completion.
+    template <class F>
+    void for_chunks(size_t n, F&& f) {
+        size_t parts = this->parts(n);
+        if (parts <= 1 || inside_job_) {
+            for (size_t part = 0; part < parts; ++part) {
+                f(n * part / parts, n * (part + 1) / parts);
+            }
+            return;
+        }
+        std::function<void(size_t)> task = [&](size_t part) {
+            f(n * part / parts, n * (part + 1) / parts);
+        };
+        run(task, parts);
+    }
+
+    static thread_pool& global() {
+        static thread_pool pool;
+        return pool;
+    }
+
+private:
+    void run(const std::function<void(size_t)>& task, size_t parts) {
+        std::lock_guard<std::mutex> submit(submit_mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (workers_.size() + 1 < threads_) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+        task_ = &task;
+        parts_ = parts;
+        next_ = 0;
+        pending_ = parts;
+        error_ = nullptr;
+        generation_++;
+        lock.unlock();
+        wake_.notify_all();
+
+        work(task, parts);
+
+        lock.lock();
+        done_.wait(lock, [this] { return pending_ == 0 && active_ == 0; });
+        task_ = nullptr;
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+    void worker_loop() {
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stop_ || (task_ != nullptr && generation_ != seen); });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            const std::function<void(size_t)>& task = *task_;
+            size_t parts = parts_;
+            active_++;
+            lock.unlock();
+            work(task, parts);
+            lock.lock();
+            active_--;
+            if (active_ == 0) {
+                done_.notify_all();
+            }
+        }
+    }
+
+    void work(const std::function<void(size_t)>& task, size_t parts) {
+        inside_job_ = true;
+        for (size_t part = next_++; part < parts; part = next_++) {
+            MY_VECTOR_TRY {
+                task(part);
+            } MY_VECTOR_CATCH_ALL {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+            }
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_.notify_all();
+            }
+        }
+        inside_job_ = false;
+    }
+
+    size_t threads_;
+    std::vector<std::thread> workers_;
+    std::mutex submit_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t parts_ = 0;
+    size_t generation_ = 0;
+    size_t active_ = 0;
+    bool stop_ = false;
+    std::atomic<size_t> next_ = 0;
+    std::atomic<size_t> pending_ = 0;
+    std::exception_ptr error_;
+
+    static inline thread_local bool inside_job_ = false;
+};
+
+// Opt-in tag for my_vector's parallel operations. Jobs smaller than min_bytes stay on the calling
+// thread; pool == nullptr means thread_pool::global().
+struct parallel_policy {
+    thread_pool* pool = nullptr;
+    size_t min_bytes = size_t(1) << 22;
+
+    thread_pool& get_pool() const {
+        return pool != nullptr ? *pool : thread_pool::global();
+    }
+
+    size_t parts(size_t n, size_t item_bytes) const {
+        if (n * item_bytes < min_bytes) {
+            return std::min<size_t>(n, 1);
+        }
+        return get_pool().parts(n);
+    }
+
+    template <class F>
+    void for_chunks(size_t n, size_t item_bytes, F&& f) const {
+        if (n * item_bytes < min_bytes) {
+            if (n != 0) {
+                f(size_t(0), n);
+            }
+            return;
+        }
+        get_pool().for_chunks(n, f);
+    }
+};
+
+inline constexpr parallel_policy par{};
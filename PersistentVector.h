@@ -0,0 +1,670 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+#include "Vector.h"
+
+template <class T>
+class transient_vector;
+
+// Immutable vector with structural sharing: a 32-way trie of leaves plus a separate tail leaf,
+// as in Clojure's PersistentVector. push_back, pop_back, set and slicing return a new version
+// that shares all nodes except the O(log32 n) ones on the changed path, so keeping many versions
+// of a large array costs O(log n) memory per version. Nodes are reference counted atomically, so
+// versions may be shared across threads.
+//
+// Every operation edits its own copy of the root and tail in place and copies each node on the
+// way that another version still references. transient_vector runs the same edits without
+// taking a copy first: after the first change of a path its nodes are owned exclusively and
+// later changes are done in place, which makes batches of updates cheap.
+//
+// Slices keep the trie of their source and record where they start; elements in front of a
+// slice stay allocated until no version references their leaves.
+template <class T>
+class persistent_vector {
+    friend class transient_vector<T>;
+
+    static constexpr size_t bits_ = 5;
+    static constexpr size_t width_ = size_t(1) << bits_;
+    static constexpr size_t mask_ = width_ - 1;
+
+    struct node {
+        std::atomic<uint32_t> refs = 1;
+        // Children in use for inner nodes, constructed elements for leaves.
+        uint32_t count = 0;
+    };
+
+    struct inner : node {
+        node* children[width_] = {};
+    };
+
+    struct leaf : node {
+        leaf() {
+        }
+
+        ~leaf() {
+        }
+
+        union {
+            T items[width_];
+        };
+    };
+
+public:
+    // Random access over the elements; keeps a pointer to the current leaf, so stepping through
+    // the vector descends the trie once per 32 elements.
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        const_iterator(const persistent_vector* obj, size_t ind) : obj_(obj), ind_(ind) {
+        }
+
+        reference operator*() const {
+            size_t pos = obj_->offset_ + ind_;
+            if (leaf_ == nullptr || pos - leaf_begin_ >= width_) {
+                leaf_begin_ = pos & ~mask_;
+                leaf_ = obj_->leaf_for(pos);
+            }
+            return leaf_->items[pos - leaf_begin_];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        reference operator[](difference_type diff) const {
+            return *(*this + diff);
+        }
+
+        const_iterator& operator+=(difference_type diff) {
+            ind_ += diff;
+            return *this;
+        }
+
+        const_iterator& operator-=(difference_type diff) {
+            ind_ -= diff;
+            return *this;
+        }
+
+        const_iterator operator+(difference_type diff) const {
+            const_iterator res = *this;
+            res += diff;
+            return res;
+        }
+
+        friend const_iterator operator+(difference_type diff, const const_iterator& it) {
+            return it + diff;
+        }
+
+        const_iterator operator-(difference_type diff) const {
+            const_iterator res = *this;
+            res -= diff;
+            return res;
+        }
+
+        difference_type operator-(const const_iterator& anoth) const {
+            return static_cast<difference_type>(ind_) - static_cast<difference_type>(anoth.ind_);
+        }
+
+        const_iterator& operator++() {
+            ind_++;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator res = *this;
+            ind_++;
+            return res;
+        }
+
+        const_iterator& operator--() {
+            ind_--;
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator res = *this;
+            ind_--;
+            return res;
+        }
+
+        bool operator==(const const_iterator& anoth) const {
+            return ind_ == anoth.ind_;
+        }
+
+        std::strong_ordering operator<=>(const const_iterator& anoth) const {
+            return ind_ <=> anoth.ind_;
+        }
+
+    private:
+        const persistent_vector* obj_ = nullptr;
+        size_t ind_ = 0;
+        mutable const leaf* leaf_ = nullptr;
+        mutable size_t leaf_begin_ = 0;
+    };
+
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = const_iterator;
+
+    persistent_vector() {
+    }
+
+    persistent_vector(std::initializer_list<T> list) : persistent_vector(list.begin(), list.end()) {
+    }
+
+    // Built in a local vector, whose destructor frees the nodes if a copy throws.
+    template <std::input_iterator It>
+    persistent_vector(It first, It last) {
+        persistent_vector res;
+        for (; first != last; ++first) {
+            res.push_back_in_place(*first);
+        }
+        swap(res);
+    }
+
+    template <class Allocator, class GrowthPolicy>
+    explicit persistent_vector(const my_vector<T, Allocator, GrowthPolicy>& items)
+        : persistent_vector(items.begin(), items.end()) {
+    }
+
+    persistent_vector(const persistent_vector& anoth)
+        : root_(acquire(anoth.root_)),
+          tail_(acquire(anoth.tail_)),
+          size_(anoth.size_),
+          offset_(anoth.offset_),
+          shift_(anoth.shift_) {
+    }
+
+    persistent_vector(persistent_vector&& anoth) noexcept {
+        swap(anoth);
+    }
+
+    persistent_vector& operator=(persistent_vector anoth) noexcept {
+        swap(anoth);
+        return *this;
+    }
+
+    ~persistent_vector() {
+        clear_in_place();
+    }
+
+    [[nodiscard]] persistent_vector push_back(const T& val) const {
+        persistent_vector res = *this;
+        res.push_back_in_place(val);
+        return res;
+    }
+
+    [[nodiscard]] persistent_vector push_back(T&& val) const {
+        persistent_vector res = *this;
+        res.push_back_in_place(std::move(val));
+        return res;
+    }
+
+    [[nodiscard]] persistent_vector pop_back() const {
+        if (empty()) {
+            throw std::exception();
+        }
+        persistent_vector res = *this;
+        res.pop_back_in_place();
+        return res;
+    }
+
+    [[nodiscard]] persistent_vector set(size_t ind, const T& val) const {
+        check_range(ind);
+        persistent_vector res = *this;
+        res.set_in_place(ind, val);
+        return res;
+    }
+
+    [[nodiscard]] persistent_vector set(size_t ind, T&& val) const {
+        check_range(ind);
+        persistent_vector res = *this;
+        res.set_in_place(ind, std::move(val));
+        return res;
+    }
+
+    // The first count elements.
+    [[nodiscard]] persistent_vector take(size_t count) const {
+        persistent_vector res = *this;
+        res.take_in_place(count);
+        return res;
+    }
+
+    // All but the first count elements.
+    [[nodiscard]] persistent_vector drop(size_t count) const {
+        persistent_vector res = *this;
+        res.drop_in_place(count);
+        return res;
+    }
+
+    // Elements [first, last).
+    [[nodiscard]] persistent_vector slice(size_t first, size_t last) const {
+        if (first > last || last > size()) {
+            throw std::out_of_range("persistent_vector::slice");
+        }
+        persistent_vector res = *this;
+        res.take_in_place(last);
+        res.drop_in_place(first);
+        return res;
+    }
+
+    // A transient starting from this version; see transient_vector.
+    transient_vector<T> transient() const {
+        return transient_vector<T>(*this);
+    }
+
+    // Copies the elements into a flat vector, one leaf at a time.
+    my_vector<T> to_vector() const {
+        my_vector<T> res;
+        res.reserve(size());
+        for (size_t pos = offset_; pos < size_;) {
+            size_t begin = pos & ~mask_;
+            const leaf* items = leaf_for(pos);
+            size_t end = std::min(begin + items->count, size_);
+            res.append_range(std::ranges::subrange(items->items + (pos - begin),
+                                                   items->items + (end - begin)));
+            pos = end;
+        }
+        return res;
+    }
+
+    const T& operator[](size_t ind) const {
+        size_t pos = offset_ + ind;
+        return leaf_for(pos)->items[pos & mask_];
+    }
+
+    const T& at(size_t ind) const {
+        check_range(ind);
+        return (*this)[ind];
+    }
+
+    const T& front() const {
+        return (*this)[0];
+    }
+
+    const T& back() const {
+        return (*this)[size() - 1];
+    }
+
+    size_t size() const {
+        return size_ - offset_;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    void swap(persistent_vector& anoth) noexcept {
+        std::swap(root_, anoth.root_);
+        std::swap(tail_, anoth.tail_);
+        std::swap(size_, anoth.size_);
+        std::swap(offset_, anoth.offset_);
+        std::swap(shift_, anoth.shift_);
+    }
+
+    bool operator==(const persistent_vector& anoth) const {
+        if (root_ == anoth.root_ && tail_ == anoth.tail_ && size_ == anoth.size_ &&
+            offset_ == anoth.offset_) {
+            return true;
+        }
+        return size() == anoth.size() && std::equal(begin(), end(), anoth.begin());
+    }
+
+    bool operator!=(const persistent_vector& anoth) const {
+        return !(*this == anoth);
+    }
+
+private:
+    void check_range(size_t ind) const {
+        if (ind >= size()) {
+            throw std::out_of_range("persistent_vector::at");
+        }
+    }
+
+    // Index of the first element in the tail; everything before it is in the trie.
+    static size_t tail_offset(size_t size) {
+        return size == 0 ? 0 : (size - 1) & ~mask_;
+    }
+
+    const leaf* leaf_for(size_t pos) const {
+        if (pos >= tail_offset(size_)) {
+            return tail_;
+        }
+        const node* cur = root_;
+        for (size_t level = shift_; level > 0; level -= bits_) {
+            cur = static_cast<const inner*>(cur)->children[(pos >> level) & mask_];
+        }
+        return static_cast<const leaf*>(cur);
+    }
+
+    template <class Node>
+    static Node* acquire(Node* ptr) {
+        if (ptr != nullptr) {
+            ptr->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        return ptr;
+    }
+
+    // Drops a reference to a node at `level` (0 for leaves); the last one frees the subtree.
+    static void release(node* ptr, size_t level) {
+        if (ptr == nullptr || ptr->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if (level == 0) {
+            leaf* items = static_cast<leaf*>(ptr);
+            std::destroy_n(items->items, items->count);
+            delete items;
+            return;
+        }
+        inner* branch = static_cast<inner*>(ptr);
+        for (uint32_t i = 0; i < branch->count; ++i) {
+            release(branch->children[i], level - bits_);
+        }
+        delete branch;
+    }
+
+    static bool shared(const node* ptr) {
+        return ptr->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    // Makes the inner node in slot exclusively ours, copying it (or creating an empty one) if
+    // needed, and returns it. slot is updated at once so a later exception leaves no dangling
+    // pointer.
+    static inner* edit_inner(node*& slot, size_t level) {
+        inner* cur = static_cast<inner*>(slot);
+        if (cur != nullptr && !shared(cur)) {
+            return cur;
+        }
+        inner* copy = new inner;
+        if (cur != nullptr) {
+            copy->count = cur->count;
+            for (uint32_t i = 0; i < cur->count; ++i) {
+                copy->children[i] = acquire(cur->children[i]);
+            }
+            release(cur, level);
+        }
+        slot = copy;
+        return copy;
+    }
+
+    // The same for a leaf; copies the first `keep` elements of a shared one.
+    template <class Slot>
+    static leaf* edit_leaf(Slot& slot, size_t keep) {
+        leaf* cur = static_cast<leaf*>(slot);
+        if (!shared(cur)) {
+            return cur;
+        }
+        leaf* copy = new leaf;
+        try {
+            for (; copy->count < keep; ++copy->count) {
+                std::construct_at(copy->items + copy->count, cur->items[copy->count]);
+            }
+        } catch (...) {
+            std::destroy_n(copy->items, copy->count);
+            delete copy;
+            throw;
+        }
+        release(cur, 0);
+        slot = copy;
+        return copy;
+    }
+
+    template <class U>
+    void push_back_in_place(U&& val) {
+        if (tail_ != nullptr && size_ - tail_offset(size_) < width_) {
+            leaf* tail = edit_leaf(tail_, tail_->count);
+            std::construct_at(tail->items + tail->count, std::forward<U>(val));
+            tail->count++;
+            size_++;
+            return;
+        }
+        leaf* fresh = new leaf;
+        try {
+            std::construct_at(fresh->items, std::forward<U>(val));
+        } catch (...) {
+            delete fresh;
+            throw;
+        }
+        fresh->count = 1;
+        if (tail_ != nullptr) {
+            try {
+                push_tail();
+            } catch (...) {
+                release(fresh, 0);
+                throw;
+            }
+        }
+        tail_ = fresh;
+        size_++;
+    }
+
+    // Moves the full tail into the trie, growing the trie by a level when the root is full.
+    void push_tail() {
+        size_t pos = size_ - width_;
+        if (root_ != nullptr && (pos >> bits_) >= (size_t(1) << shift_)) {
+            inner* grown = new inner;
+            grown->children[0] = root_;
+            grown->count = 1;
+            root_ = grown;
+            shift_ += bits_;
+        }
+        node** slot = &root_;
+        for (size_t level = shift_; level > 0; level -= bits_) {
+            inner* branch = edit_inner(*slot, level);
+            size_t sub = (pos >> level) & mask_;
+            branch->count = std::max<uint32_t>(branch->count, sub + 1);
+            slot = &branch->children[sub];
+        }
+        *slot = tail_;
+        tail_ = nullptr;
+    }
+
+    void pop_back_in_place() {
+        if (size() == 1) {
+            clear_in_place();
+            return;
+        }
+        if (tail_->count > 1) {
+            leaf* tail = edit_leaf(tail_, tail_->count);
+            std::destroy_at(tail->items + tail->count - 1);
+            tail->count--;
+            size_--;
+            return;
+        }
+        leaf* last = acquire(const_cast<leaf*>(leaf_for(size_ - 2)));
+        release(tail_, 0);
+        tail_ = last;
+        trim_trie(size_ - 1 - width_);
+        size_--;
+    }
+
+    template <class U>
+    void set_in_place(size_t ind, U&& val) {
+        size_t pos = offset_ + ind;
+        size_t tail_begin = tail_offset(size_);
+        if (pos >= tail_begin) {
+            edit_leaf(tail_, tail_->count)->items[pos - tail_begin] = std::forward<U>(val);
+            return;
+        }
+        node** slot = &root_;
+        for (size_t level = shift_; level > 0; level -= bits_) {
+            slot = &edit_inner(*slot, level)->children[(pos >> level) & mask_];
+        }
+        edit_leaf(*slot, width_)->items[pos & mask_] = std::forward<U>(val);
+    }
+
+    void take_in_place(size_t count) {
+        if (count >= size()) {
+            return;
+        }
+        if (count == 0) {
+            clear_in_place();
+            return;
+        }
+        size_t new_size = offset_ + count;
+        size_t new_tail_begin = tail_offset(new_size);
+        if (new_tail_begin < tail_offset(size_)) {
+            leaf* last = acquire(const_cast<leaf*>(leaf_for(new_tail_begin)));
+            release(tail_, 0);
+            tail_ = last;
+            trim_trie(new_tail_begin);
+        }
+        size_t keep = new_size - new_tail_begin;
+        leaf* tail = edit_leaf(tail_, keep);
+        std::destroy(tail->items + keep, tail->items + tail->count);
+        tail->count = keep;
+        size_ = new_size;
+    }
+
+    void drop_in_place(size_t count) {
+        if (count >= size()) {
+            clear_in_place();
+            return;
+        }
+        offset_ += count;
+    }
+
+    // Cuts the trie down to its first `keep` elements (a multiple of the leaf size) and removes
+    // root levels that became unnecessary.
+    void trim_trie(size_t keep) {
+        if (keep == 0) {
+            release(root_, shift_);
+            root_ = nullptr;
+            shift_ = bits_;
+            return;
+        }
+        node** slot = &root_;
+        for (size_t level = shift_; level > 0; level -= bits_) {
+            inner* branch = edit_inner(*slot, level);
+            size_t last = (keep - 1) >> level;
+            for (uint32_t i = last + 1; i < branch->count; ++i) {
+                release(branch->children[i], level - bits_);
+                branch->children[i] = nullptr;
+            }
+            branch->count = last + 1;
+            keep -= last << level;
+            slot = &branch->children[last];
+        }
+        while (shift_ > bits_ && root_->count == 1) {
+            inner* old_root = static_cast<inner*>(root_);
+            root_ = acquire(old_root->children[0]);
+            release(old_root, shift_);
+            shift_ -= bits_;
+        }
+    }
+
+    void clear_in_place() {
+        release(root_, shift_);
+        release(tail_, 0);
+        root_ = nullptr;
+        tail_ = nullptr;
+        size_ = 0;
+        offset_ = 0;
+        shift_ = bits_;
+    }
+
+    node* root_ = nullptr;
+    leaf* tail_ = nullptr;
+    // Index one past the last element in the trie and tail; the vector starts at offset_.
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    size_t shift_ = bits_;
+};
+
+// Batch-mutation mode of persistent_vector: the same operations, applied in place. Nodes shared
+// with other versions are copied on first change, after which the transient owns them, so n
+// updates cost about as much as n updates of a flat array plus one path copy each 32 elements.
+// persistent() hands the result back as a version in O(1). Not safe for concurrent use.
+template <class T>
+class transient_vector {
+public:
+    transient_vector() {
+    }
+
+    explicit transient_vector(persistent_vector<T> vec) : vec_(std::move(vec)) {
+    }
+
+    void push_back(const T& val) {
+        vec_.push_back_in_place(val);
+    }
+
+    void push_back(T&& val) {
+        vec_.push_back_in_place(std::move(val));
+    }
+
+    void pop_back() {
+        if (empty()) {
+            throw std::exception();
+        }
+        vec_.pop_back_in_place();
+    }
+
+    void set(size_t ind, const T& val) {
+        vec_.check_range(ind);
+        vec_.set_in_place(ind, val);
+    }
+
+    void set(size_t ind, T&& val) {
+        vec_.check_range(ind);
+        vec_.set_in_place(ind, std::move(val));
+    }
+
+    void take(size_t count) {
+        vec_.take_in_place(count);
+    }
+
+    void drop(size_t count) {
+        vec_.drop_in_place(count);
+    }
+
+    const T& operator[](size_t ind) const {
+        return vec_[ind];
+    }
+
+    size_t size() const {
+        return vec_.size();
+    }
+
+    bool empty() const {
+        return vec_.empty();
+    }
+
+    my_vector<T> to_vector() const {
+        return vec_.to_vector();
+    }
+
+    // Ends the batch: returns the result and leaves the transient empty.
+    persistent_vector<T> persistent() {
+        return std::exchange(vec_, persistent_vector<T>());
+    }
+
+private:
+    persistent_vector<T> vec_;
+};
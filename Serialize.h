@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Vector.h"
+
+// Binary format of write_vector(): this header, then either count raw elements (one block) or
+// count values written by vector_codec<T>. Multi-byte fields use the host's byte order.
+struct vector_stream_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t encoding;
+    uint32_t element_size;
+    uint32_t reserved;
+    uint64_t count;
+};
+
+enum class vector_encoding : uint16_t { raw, codec };
+
+inline constexpr uint32_t vector_stream_magic = 0x5356594d;  // "MYVS"
+inline constexpr uint16_t vector_stream_version = 1;
+
+// Per-element encoding for types that cannot be written as raw bytes. Specialize it with
+// static void encode(std::ostream&, const T&) and static T decode(std::istream&).
+template <class T>
+struct vector_codec;
+
+// Length-prefixed characters.
+template <class Char, class Traits, class Alloc>
+struct vector_codec<std::basic_string<Char, Traits, Alloc>> {
+    using string = std::basic_string<Char, Traits, Alloc>;
+
+    static void encode(std::ostream& out, const string& str) {
+        uint64_t size = str.size();
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char*>(str.data()), size * sizeof(Char));
+    }
+
+    // The string grows by at most chunk_ characters per read, so a corrupted length fails at the
+    // end of the input instead of allocating it up front.
+    static string decode(std::istream& in) {
+        uint64_t size = 0;
+        in.read(reinterpret_cast<char*>(&size), sizeof(size));
+        string str;
+        while (in && str.size() < size) {
+            size_t done = str.size();
+            size_t count = std::min<uint64_t>(size - done, chunk_);
+            str.resize(done + count);
+            in.read(reinterpret_cast<char*>(str.data() + done), count * sizeof(Char));
+        }
+        if (!in) {
+            throw std::runtime_error("vector_codec: truncated string");
+        }
+        return str;
+    }
+
+private:
+    static constexpr size_t chunk_ = (size_t(1) << 16) / sizeof(Char);
+};
+
+// Elements written as one block of bytes. Reading them needs default construction to make room
+// in the vector; trivial types are not even initialized.
+template <class T>
+concept raw_serializable = std::is_trivially_copyable_v<T> && std::default_initializable<T>;
+
+template <class T>
+concept codec_serializable = requires(std::ostream& out, std::istream& in, const T& val) {
+    vector_codec<T>::encode(out, val);
+    { vector_codec<T>::decode(in) } -> std::convertible_to<T>;
+};
+
+template <class T>
+concept serializable = raw_serializable<T> || codec_serializable<T>;
+
+template <class T>
+vector_stream_header make_vector_header(size_t count) {
+    if constexpr (raw_serializable<T>) {
+        return {vector_stream_magic, vector_stream_version,
+                static_cast<uint16_t>(vector_encoding::raw), sizeof(T), 0, count};
+    } else {
+        return {vector_stream_magic, vector_stream_version,
+                static_cast<uint16_t>(vector_encoding::codec), 0, 0, count};
+    }
+}
+
+// Throws std::ios_base::failure if the stream fails.
+template <serializable T, class Allocator, class GrowthPolicy>
+void write_vector(std::ostream& out, const my_vector<T, Allocator, GrowthPolicy>& vec) {
+    vector_stream_header header = make_vector_header<T>(vec.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if constexpr (raw_serializable<T>) {
+        out.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+    } else {
+        for (const T& val : vec) {
+            vector_codec<T>::encode(out, val);
+        }
+    }
+    if (!out) {
+        throw std::ios_base::failure("write_vector: stream failed");
+    }
+}
+
+inline void write_all(int fd, const void* data, size_t bytes) {
+    const char* ptr = static_cast<const char*>(data);
+    while (bytes != 0) {
+        ssize_t done = ::write(fd, ptr, bytes);
+        if (done < 0 && errno != EINTR) {
+            throw std::system_error(errno, std::generic_category(), "write_vector");
+        }
+        if (done > 0) {
+            ptr += done;
+            bytes -= done;
+        }
+    }
+}
+
+// Writes to a file descriptor with write(2), without a stream buffer in between.
+template <raw_serializable T, class Allocator, class GrowthPolicy>
+void write_vector(int fd, const my_vector<T, Allocator, GrowthPolicy>& vec) {
+    vector_stream_header header = make_vector_header<T>(vec.size());
+    write_all(fd, &header, sizeof(header));
+    write_all(fd, vec.data(), vec.size() * sizeof(T));
+}
+
+// Reads what write_vector() wrote, chunk by chunk. Raw elements are read straight into the
+// vector's buffer after an uninitialized resize, so there is no intermediate copy. The buffer is
+// sized from the header only when the source is seekable and really holds that much data, so a
+// corrupted count cannot allocate more than one chunk ahead of the input.
+template <serializable T>
+class vector_reader {
+public:
+    explicit vector_reader(std::istream& in, size_t chunk_bytes = size_t(1) << 22)
+        : in_(&in), chunk_bytes_(chunk_bytes) {
+        read_header();
+    }
+
+    explicit vector_reader(int fd, size_t chunk_bytes = size_t(1) << 22)
+    requires raw_serializable<T>
+        : fd_(fd), chunk_bytes_(chunk_bytes) {
+        read_header();
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    size_t remaining() const {
+        return remaining_;
+    }
+
+    // Appends up to max_count elements to vec and returns how many; 0 once everything is read.
+    // Throws std::runtime_error on truncated input, leaving vec as it was before the call.
+    template <class Allocator, class GrowthPolicy>
+    size_t read_some(my_vector<T, Allocator, GrowthPolicy>& vec, size_t max_count) {
+        size_t count = std::min(max_count, remaining_);
+        size_t old_size = vec.size();
+        try {
+            if constexpr (raw_serializable<T>) {
+                if constexpr (std::is_trivial_v<T>) {
+                    vec.resize_uninitialized(old_size + count);
+                } else {
+                    vec.resize_default_init(old_size + count);
+                }
+                read_bytes(vec.data() + old_size, count * sizeof(T));
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    vec.push_back(vector_codec<T>::decode(*in_));
+                }
+            }
+        } catch (...) {
+            vec.erase(vec.begin() + old_size, vec.end());
+            throw;
+        }
+        remaining_ -= count;
+        return count;
+    }
+
+    // Appends all remaining elements to vec.
+    template <class Allocator, class GrowthPolicy>
+    void read_all(my_vector<T, Allocator, GrowthPolicy>& vec) {
+        size_t chunk = std::max<size_t>(1, chunk_bytes_ / sizeof(T));
+        if (remaining_ <= chunk ||
+            (raw_serializable<T> && available_bytes() / sizeof(T) >= remaining_)) {
+            vec.reserve(vec.size() + remaining_);
+        }
+        while (read_some(vec, chunk) != 0) {
+        }
+    }
+
+private:
+    void read_header() {
+        vector_stream_header header;
+        read_bytes(&header, sizeof(header));
+        vector_stream_header expected = make_vector_header<T>(header.count);
+        if (header.magic != expected.magic || header.version != expected.version) {
+            throw std::runtime_error("vector_reader: not a my_vector stream");
+        }
+        if (header.encoding != expected.encoding || header.element_size != expected.element_size) {
+            throw std::runtime_error("vector_reader: stream holds a different element type");
+        }
+        count_ = remaining_ = header.count;
+    }
+
+    // Bytes left in a seekable source, or 0 if unknown.
+    size_t available_bytes() {
+        if (in_ != nullptr) {
+            std::istream::pos_type pos = in_->tellg();
+            if (pos == std::istream::pos_type(-1) || !in_->seekg(0, std::ios_base::end)) {
+                in_->clear();
+                return 0;
+            }
+            std::istream::pos_type end = in_->tellg();
+            in_->seekg(pos);
+            return end > pos ? static_cast<size_t>(end - pos) : 0;
+        }
+        off_t pos = lseek(fd_, 0, SEEK_CUR);
+        struct stat st;
+        if (pos < 0 || fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < pos) {
+            return 0;
+        }
+        return st.st_size - pos;
+    }
+
+    void read_bytes(void* data, size_t bytes) {
+        if (in_ != nullptr) {
+            in_->read(static_cast<char*>(data), bytes);
+            if (static_cast<size_t>(in_->gcount()) != bytes) {
+                throw std::runtime_error("vector_reader: unexpected end of data");
+            }
+            return;
+        }
+        char* ptr = static_cast<char*>(data);
+        while (bytes != 0) {
+            ssize_t done = ::read(fd_, ptr, bytes);
+            if (done < 0 && errno != EINTR) {
+                throw std::system_error(errno, std::generic_category(), "vector_reader");
+            }
+            if (done == 0) {
+                throw std::runtime_error("vector_reader: unexpected end of data");
+            }
+            if (done > 0) {
+                ptr += done;
+                bytes -= done;
+            }
+        }
+    }
+
+    std::istream* in_ = nullptr;
+    int fd_ = -1;
+    size_t chunk_bytes_;
+    size_t count_ = 0;
+    size_t remaining_ = 0;
+};
+
+// Replaces the contents of vec with what write_vector() wrote. On failure vec is left empty.
+template <serializable T, class Allocator, class GrowthPolicy>
+void read_vector(std::istream& in, my_vector<T, Allocator, GrowthPolicy>& vec) {
+    vec.clear();
+    try {
+        vector_reader<T>(in).read_all(vec);
+    } catch (...) {
+        vec.clear();
+        throw;
+    }
+}
+
+template <raw_serializable T, class Allocator, class GrowthPolicy>
+void read_vector(int fd, my_vector<T, Allocator, GrowthPolicy>& vec) {
+    vec.clear();
+    try {
+        vector_reader<T>(fd).read_all(vec);
+    } catch (...) {
+        vec.clear();
+        throw;
+    }
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+// Vectorized kernels for arrays of arithmetic types. Each kernel is written as fixed-size chunks
+// that the compiler turns into SIMD code, and is compiled twice on x86-64: for the SSE2 baseline
+// and for AVX2, picked at runtime from the CPU features. Elsewhere only the portable build is
+// used. Results match the scalar std:: algorithms, including for NaNs and signed zeros.
+template <class T>
+inline constexpr bool simd_enabled = std::is_arithmetic_v<T>;
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MY_VECTOR_SIMD_DISPATCH
+#endif
+
+inline bool simd_use_avx2() {
+#ifdef MY_VECTOR_SIMD_DISPATCH
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+template <class T>
+struct simd_kernels {
+    // Elements per chunk: eight AVX2 registers.
+    static constexpr size_t chunk_ = 256 / sizeof(T);
+    static constexpr size_t lanes_ = 32 / sizeof(T);
+
+    struct mismatch {
+        [[gnu::always_inline]] static size_t run(const T* a, const T* b, size_t n) {
+            size_t i = 0;
+            for (; i + chunk_ <= n; i += chunk_) {
+                unsigned diff = 0;
+                for (size_t j = 0; j < chunk_; ++j) {
+                    diff |= a[i + j] != b[i + j];
+                }
+                if (diff != 0) {
+                    break;
+                }
+            }
+            for (; i < n && a[i] == b[i]; ++i) {
+            }
+            return i;
+        }
+    };
+
+    struct find {
+        [[gnu::always_inline]] static size_t run(const T* a, size_t n, T val) {
+            size_t i = 0;
+            for (; i + chunk_ <= n; i += chunk_) {
+                unsigned found = 0;
+                for (size_t j = 0; j < chunk_; ++j) {
+                    found |= a[i + j] == val;
+                }
+                if (found != 0) {
+                    break;
+                }
+            }
+            for (; i < n && !(a[i] == val); ++i) {
+            }
+            return i;
+        }
+    };
+
+    struct count {
+        [[gnu::always_inline]] static size_t run(const T* a, size_t n, T val) {
+            size_t res = 0;
+            size_t i = 0;
+            for (; i + chunk_ <= n; i += chunk_) {
+                unsigned found = 0;
+                for (size_t j = 0; j < chunk_; ++j) {
+                    found += a[i + j] == val;
+                }
+                res += found;
+            }
+            for (; i < n; ++i) {
+                res += a[i] == val;
+            }
+            return res;
+        }
+    };
+
+    struct fill {
+        [[gnu::always_inline]] static void run(T* a, size_t n, T val) {
+            size_t i = 0;
+            for (; i + chunk_ <= n; i += chunk_) {
+                for (size_t j = 0; j < chunk_; ++j) {
+                    a[i + j] = val;
+                }
+            }
+            // std::fill rather than an indexed loop: after inlining, GCC's iteration-count check
+            // misfires on a[i] when n is not known to fit the buffer.
+            std::fill(a + i, a + n, val);
+        }
+    };
+
+    // Per-lane running extremum; `x < acc ? x : acc` maps to minps/pminsd and skips NaNs the same
+    // way std::min_element does. n must be positive.
+    template <bool Max>
+    struct extremum {
+        [[gnu::always_inline]] static T run(const T* a, size_t n) {
+            T acc[lanes_];
+            for (size_t j = 0; j < lanes_; ++j) {
+                acc[j] = a[0];
+            }
+            size_t i = 0;
+            for (; i + lanes_ <= n; i += lanes_) {
+                for (size_t j = 0; j < lanes_; ++j) {
+                    acc[j] = better(a[i + j], acc[j]) ? a[i + j] : acc[j];
+                }
+            }
+            T res = a[0];
+            for (size_t j = 0; j < lanes_; ++j) {
+                res = better(acc[j], res) ? acc[j] : res;
+            }
+            for (; i < n; ++i) {
+                res = better(a[i], res) ? a[i] : res;
+            }
+            return res;
+        }
+
+        [[gnu::always_inline]] static bool better(T x, T y) {
+            return Max ? y < x : x < y;
+        }
+    };
+};
+
+#ifdef MY_VECTOR_SIMD_DISPATCH
+template <class Kernel, class... Args>
+[[gnu::target("avx2")]] auto simd_run_avx2(Args... args) {
+    return Kernel::run(args...);
+}
+#endif
+
+template <class Kernel, class... Args>
+auto simd_run(Args... args) {
+#ifdef MY_VECTOR_SIMD_DISPATCH
+    if (simd_use_avx2()) {
+        return simd_run_avx2<Kernel>(args...);
+    }
+#endif
+    return Kernel::run(args...);
+}
+
+// Index of the first position where a and b differ, or n.
+template <class T>
+size_t simd_mismatch(const T* a, const T* b, size_t n) {
+    return simd_run<typename simd_kernels<T>::mismatch>(a, b, n);
+}
+
+template <class T>
+bool simd_equal(const T* a, const T* b, size_t n) {
+    return simd_mismatch(a, b, n) == n;
+}
+
+// Index of the first element equal to val, or n.
+template <class T>
+size_t simd_find(const T* a, size_t n, T val) {
+    return simd_run<typename simd_kernels<T>::find>(a, n, val);
+}
+
+template <class T>
+size_t simd_count(const T* a, size_t n, T val) {
+    return simd_run<typename simd_kernels<T>::count>(a, n, val);
+}
+
+template <class T>
+void simd_fill(T* a, size_t n, T val) {
+    simd_run<typename simd_kernels<T>::fill>(a, n, val);
+}
+
+// The first element equal to the extremum val. The lanes keep their own first extremum, so
+// among equal floating-point values such as -0.0 and 0.0 the reduction may pick a later one;
+// std::min_element and std::max_element return the first. A NaN extremum can only be a[0].
+template <class T>
+T simd_first_equal(const T* a, size_t n, T val) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (val == val) {
+            return a[simd_find(a, n, val)];
+        }
+    }
+    return val;
+}
+
+template <class T>
+T simd_min(const T* a, size_t n) {
+    T res = simd_run<typename simd_kernels<T>::template extremum<false>>(a, n);
+    return simd_first_equal(a, n, res);
+}
+
+template <class T>
+T simd_max(const T* a, size_t n) {
+    T res = simd_run<typename simd_kernels<T>::template extremum<true>>(a, n);
+    return simd_first_equal(a, n, res);
+}
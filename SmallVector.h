@@ -0,0 +1,461 @@
+#pragma once
+
+#include "Vector.h"
+
+// Vector with room for N elements inside the object itself. It only touches the allocator once
+// it grows past N elements; clear() and shrink_to_fit() return it to the inline buffer.
+template <class T, size_t N, class Allocator = std::allocator<T>>
+class small_vector {
+    static_assert(N > 0, "small_vector needs a non-empty inline buffer");
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    small_vector() {
+    }
+
+    explicit small_vector(const Allocator& alloc) : alloc_(alloc) {
+    }
+
+    small_vector(const small_vector& anoth)
+        : alloc_(alloc_traits::select_on_container_copy_construction(anoth.alloc_)) {
+        append_copies(anoth.begin(), anoth.end());
+    }
+
+    small_vector(small_vector&& anoth) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : alloc_(anoth.alloc_) {
+        take(anoth);
+    }
+
+    small_vector(size_t size, const T& val = T(), const Allocator& alloc = Allocator())
+        : alloc_(alloc) {
+        assign(size, val);
+    }
+
+    small_vector(std::initializer_list<T> list, const Allocator& alloc = Allocator())
+        : alloc_(alloc) {
+        append_copies(list.begin(), list.end());
+    }
+
+    ~small_vector() {
+        clear();
+    }
+
+    small_vector& operator=(const small_vector& anoth) {
+        if (this == &anoth) {
+            return *this;
+        }
+        clear();
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+            alloc_ = anoth.alloc_;
+        }
+        append_copies(anoth.begin(), anoth.end());
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& anoth) {
+        if (this == &anoth) {
+            return *this;
+        }
+        clear();
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+            alloc_ = std::move(anoth.alloc_);
+        }
+        take(anoth);
+        return *this;
+    }
+
+    void resize(size_t new_size) {
+        if (new_size < size_) {
+            destroy(data_ + new_size, data_ + size_);
+            size_ = new_size;
+            return;
+        }
+        reserve(new_size);
+        for (; size_ < new_size; ++size_) {
+            construct(data_ + size_);
+        }
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity > capacity_) {
+            relocate(allocate(new_capacity), new_capacity);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (is_inline() || size_ == capacity_) {
+            return;
+        }
+        if (size_ <= N) {
+            relocate(inline_data(), N);
+        } else {
+            relocate(allocate(size_), size_);
+        }
+    }
+
+    void assign(size_t new_size, const T& val) {
+        clear();
+        reserve(new_size);
+        for (; size_ < new_size; ++size_) {
+            construct(data_ + size_, val);
+        }
+    }
+
+    void push_back(const T& val) {
+        emplace_back(val);
+    }
+
+    void push_back(T&& val) {
+        emplace_back(std::move(val));
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            emplace_grow(size_, std::forward<Args>(args)...);
+        } else {
+            construct(data_ + size_, std::forward<Args>(args)...);
+            size_++;
+        }
+        return data_[size_ - 1];
+    }
+
+    void pop_back() {
+        if (size_ == 0) {
+            throw std::exception();
+        }
+        size_--;
+        destroy(data_ + size_, data_ + size_ + 1);
+    }
+
+    T& operator[](size_t ind) {
+        check_index(ind);
+        return data_[ind];
+    }
+
+    const T& operator[](size_t ind) const {
+        check_index(ind);
+        return data_[ind];
+    }
+
+    T& at(size_t ind) {
+        if (ind >= size_) {
+            throw std::out_of_range("small_vector::at");
+        }
+        return data_[ind];
+    }
+
+    const T& at(size_t ind) const {
+        if (ind >= size_) {
+            throw std::out_of_range("small_vector::at");
+        }
+        return data_[ind];
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    bool is_inline() const {
+        return data_ == inline_data();
+    }
+
+    Allocator get_allocator() const {
+        return alloc_;
+    }
+
+    void swap(small_vector& anoth) {
+        if (!is_inline() && !anoth.is_inline()) {
+            if constexpr (alloc_traits::propagate_on_container_swap::value) {
+                std::swap(alloc_, anoth.alloc_);
+            }
+            std::swap(data_, anoth.data_);
+            std::swap(size_, anoth.size_);
+            std::swap(capacity_, anoth.capacity_);
+            return;
+        }
+        small_vector tmp(std::move(anoth));
+        anoth = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    void clear() {
+        destroy(data_, data_ + size_);
+        free_heap();
+        data_ = inline_data();
+        size_ = 0;
+        capacity_ = N;
+    }
+
+    T& back() {
+        check_index(size_ - 1);
+        return data_[size_ - 1];
+    }
+
+    const T& back() const {
+        check_index(size_ - 1);
+        return data_[size_ - 1];
+    }
+
+    T& front() {
+        check_index(0);
+        return data_[0];
+    }
+
+    const T& front() const {
+        check_index(0);
+        return data_[0];
+    }
+
+    iterator begin() {
+        return data_;
+    }
+
+    iterator end() {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const {
+        return data_;
+    }
+
+    const_iterator end() const {
+        return data_ + size_;
+    }
+
+    T* data() {
+        return data_;
+    }
+
+    const T* data() const {
+        return data_;
+    }
+
+    iterator insert(const_iterator it, const T& val) {
+        return emplace(it, val);
+    }
+
+    iterator insert(const_iterator it, T&& val) {
+        return emplace(it, std::move(val));
+    }
+
+    template <class... Args>
+    iterator emplace(const_iterator it, Args&&... args) {
+        size_t ind = it - data_;
+        if (ind > size_) {
+            throw std::exception();
+        }
+        if (size_ == capacity_) {
+            emplace_grow(ind, std::forward<Args>(args)...);
+            return data_ + ind;
+        }
+
+        if constexpr (is_trivially_relocatable<T>::value) {
+            alignas(T) unsigned char buffer[sizeof(T)];
+            T* val = new (buffer) T(std::forward<Args>(args)...);
+            std::memmove(static_cast<void*>(data_ + ind + 1), static_cast<void*>(data_ + ind),
+                         (size_ - ind) * sizeof(T));
+            std::memcpy(static_cast<void*>(data_ + ind), static_cast<void*>(val), sizeof(T));
+            size_++;
+        } else if (ind == size_) {
+            construct(data_ + size_, std::forward<Args>(args)...);
+            size_++;
+        } else {
+            T val(std::forward<Args>(args)...);
+            construct(data_ + size_, std::move(data_[size_ - 1]));
+            size_++;
+            std::move_backward(data_ + ind, data_ + size_ - 2, data_ + size_ - 1);
+            data_[ind] = std::move(val);
+        }
+        return data_ + ind;
+    }
+
+    iterator erase(const_iterator it) {
+        size_t ind = it - data_;
+        if (ind >= size_) {
+            throw std::exception();
+        }
+        if constexpr (is_trivially_relocatable<T>::value) {
+            destroy(data_ + ind, data_ + ind + 1);
+            std::memmove(static_cast<void*>(data_ + ind), static_cast<void*>(data_ + ind + 1),
+                         (size_ - ind - 1) * sizeof(T));
+            size_--;
+        } else {
+            std::move(data_ + ind + 1, data_ + size_, data_ + ind);
+            pop_back();
+        }
+        return data_ + ind;
+    }
+
+    bool operator==(const small_vector& anoth) const {
+        return std::equal(begin(), end(), anoth.begin(), anoth.end());
+    }
+
+    bool operator!=(const small_vector& anoth) const {
+        return !(*this == anoth);
+    }
+
+private:
+    void check_index([[maybe_unused]] size_t ind) const {
+#ifdef MY_VECTOR_BOUNDS_CHECK
+        if (ind >= size_) {
+            throw std::out_of_range("small_vector: index out of range");
+        }
+#endif
+    }
+
+    T* inline_data() {
+        return reinterpret_cast<T*>(buffer_);
+    }
+
+    const T* inline_data() const {
+        return reinterpret_cast<const T*>(buffer_);
+    }
+
+    template <class It>
+    void append_copies(It first, It last) {
+        reserve(size_ + std::distance(first, last));
+        for (; first != last; ++first) {
+            construct(data_ + size_, *first);
+            size_++;
+        }
+    }
+
+    // Takes over the elements of anoth: its heap buffer is stolen when the allocators allow it,
+    // inline elements are moved one by one. anoth is left empty.
+    void take(small_vector& anoth) {
+        if (!anoth.is_inline() && alloc_ == anoth.alloc_) {
+            data_ = anoth.data_;
+            size_ = anoth.size_;
+            capacity_ = anoth.capacity_;
+            anoth.data_ = anoth.inline_data();
+            anoth.size_ = 0;
+            anoth.capacity_ = N;
+            return;
+        }
+        reserve(anoth.size_);
+        move_into(data_, anoth.data_, anoth.data_ + anoth.size_);
+        size_ = anoth.size_;
+        if constexpr (is_trivially_relocatable<T>::value) {
+            anoth.size_ = 0;
+        }
+        anoth.clear();
+    }
+
+    size_t grown_capacity(size_t required) const {
+        return std::max(capacity_ * 2, required);
+    }
+
+    template <class... Args>
+    void emplace_grow(size_t ind, Args&&... args) {
+        size_t capacity = grown_capacity(size_ + 1);
+        T* new_data = allocate(capacity);
+        try {
+            construct(new_data + ind, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(new_data, capacity);
+            throw;
+        }
+        try {
+            move_into(new_data, data_, data_ + ind);
+            try {
+                move_into(new_data + ind + 1, data_ + ind, data_ + size_);
+            } catch (...) {
+                destroy(new_data, new_data + ind);
+                throw;
+            }
+        } catch (...) {
+            destroy(new_data + ind, new_data + ind + 1);
+            deallocate(new_data, capacity);
+            throw;
+        }
+        size_t new_size = size_ + 1;
+        adopt(new_data, capacity);
+        size_ = new_size;
+    }
+
+    void relocate(T* new_data, size_t new_capacity) {
+        try {
+            move_into(new_data, data_, data_ + size_);
+        } catch (...) {
+            if (new_data != inline_data()) {
+                deallocate(new_data, new_capacity);
+            }
+            throw;
+        }
+        adopt(new_data, new_capacity);
+    }
+
+    // Moves or copies [first, last) into raw storage at dest; on failure nothing is left there.
+    void move_into(T* dest, T* first, T* last) {
+        if constexpr (is_trivially_relocatable<T>::value) {
+            if (first != last) {
+                std::memcpy(static_cast<void*>(dest), static_cast<void*>(first),
+                            (last - first) * sizeof(T));
+            }
+            return;
+        }
+        T* cur = dest;
+        try {
+            for (; first != last; ++first, ++cur) {
+                construct(cur, std::move_if_noexcept(*first));
+            }
+        } catch (...) {
+            destroy(dest, cur);
+            throw;
+        }
+    }
+
+    // Switches to new_data after move_into() transferred all elements there.
+    void adopt(T* new_data, size_t new_capacity) {
+        if constexpr (!is_trivially_relocatable<T>::value) {
+            destroy(data_, data_ + size_);
+        }
+        free_heap();
+        data_ = new_data;
+        capacity_ = new_capacity;
+    }
+
+    void free_heap() {
+        if (!is_inline()) {
+            deallocate(data_, capacity_);
+        }
+    }
+
+    T* allocate(size_t n) {
+        return alloc_traits::allocate(alloc_, n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        alloc_traits::deallocate(alloc_, ptr, n);
+    }
+
+    template <class... Args>
+    void construct(T* ptr, Args&&... args) {
+        alloc_traits::construct(alloc_, ptr, std::forward<Args>(args)...);
+    }
+
+    void destroy(T* first, T* last) {
+        for (; first != last; ++first) {
+            alloc_traits::destroy(alloc_, first);
+        }
+    }
+
+    [[no_unique_address]] Allocator alloc_;
+    T* data_ = inline_data();
+    size_t size_ = 0;
+    size_t capacity_ = N;
+    alignas(T) unsigned char buffer_[N * sizeof(T)];
+};
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <utility>
+
+#include "Vector.h"
+
+// Structure-of-arrays vector: field I of every element lives in its own my_vector column, so a
+// loop over one field streams through that column only. Elements are read and written through
+// tuples of references; column<I>() exposes a whole field as a span. Allocator is rebound to each
+// field's type, and every column grows by GrowthPolicy; soa_vector<Fields...> uses the defaults.
+template <class Allocator, class GrowthPolicy, class... Fields>
+class basic_soa_vector {
+    static_assert(sizeof...(Fields) > 0, "soa_vector needs at least one field");
+
+    using indices = std::index_sequence_for<Fields...>;
+
+    template <class Field>
+    using column_allocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<Field>;
+
+    template <class Field>
+    using column_type = my_vector<Field, column_allocator<Field>, GrowthPolicy>;
+
+public:
+    using value_type = std::tuple<Fields...>;
+    using reference = std::tuple<Fields&...>;
+    using const_reference = std::tuple<const Fields&...>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using allocator_type = Allocator;
+
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, value_type>;
+
+    // Random access over proxy references. Like other proxy iterators it is only an input
+    // iterator for legacy algorithms. iterator models std::random_access_iterator; const_iterator
+    // needs C++23's common_reference for tuples to do so.
+    template <bool Const>
+    class basic_iterator {
+        friend class basic_soa_vector;
+        friend class basic_iterator<!Const>;
+
+        using pointers = std::conditional_t<Const, std::tuple<const Fields*...>,
+                                            std::tuple<Fields*...>>;
+
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::tuple<Fields...>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const_reference, basic_soa_vector::reference>;
+
+        basic_iterator() = default;
+
+        template <bool Other>
+        requires(Const && !Other)
+        basic_iterator(const basic_iterator<Other>& anoth)
+            : data_(anoth.data_), ind_(anoth.ind_) {
+        }
+
+        reference operator*() const {
+            return (*this)[0];
+        }
+
+        reference operator[](difference_type diff) const {
+            return std::apply([&](auto*... column) { return reference(column[ind_ + diff]...); },
+                              data_);
+        }
+
+        basic_iterator& operator+=(difference_type diff) {
+            ind_ += diff;
+            return *this;
+        }
+
+        basic_iterator& operator-=(difference_type diff) {
+            ind_ -= diff;
+            return *this;
+        }
+
+        basic_iterator operator+(difference_type diff) const {
+            basic_iterator res = *this;
+            res += diff;
+            return res;
+        }
+
+        friend basic_iterator operator+(difference_type diff, const basic_iterator& it) {
+            return it + diff;
+        }
+
+        basic_iterator operator-(difference_type diff) const {
+            basic_iterator res = *this;
+            res -= diff;
+            return res;
+        }
+
+        difference_type operator-(const basic_iterator& anoth) const {
+            return ind_ - anoth.ind_;
+        }
+
+        basic_iterator& operator++() {
+            ind_++;
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator res = *this;
+            ind_++;
+            return res;
+        }
+
+        basic_iterator& operator--() {
+            ind_--;
+            return *this;
+        }
+
+        basic_iterator operator--(int) {
+            basic_iterator res = *this;
+            ind_--;
+            return res;
+        }
+
+        bool operator==(const basic_iterator& anoth) const {
+            return ind_ == anoth.ind_;
+        }
+
+        std::strong_ordering operator<=>(const basic_iterator& anoth) const {
+            return ind_ <=> anoth.ind_;
+        }
+
+    private:
+        basic_iterator(pointers data, difference_type ind) : data_(data), ind_(ind) {
+        }
+
+        pointers data_;
+        difference_type ind_ = 0;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    basic_soa_vector() = default;
+
+    explicit basic_soa_vector(const Allocator& alloc)
+        : columns_(column_type<Fields>(column_allocator<Fields>(alloc))...) {
+    }
+
+    Allocator get_allocator() const {
+        return Allocator(std::get<0>(columns_).get_allocator());
+    }
+
+    void reserve(size_t new_capacity) {
+        for_each_column([&](auto& column) { column.reserve(new_capacity); });
+    }
+
+    // If a column fails to grow, the columns already grown are cut back to the old size.
+    void resize(size_t new_size) {
+        size_t old_size = size();
+        try {
+            for_each_column([&](auto& column) { column.resize(new_size); });
+        } catch (...) {
+            for_each_column([&](auto& column) {
+                if (column.size() > old_size) {
+                    column.resize(old_size);
+                }
+            });
+            throw;
+        }
+    }
+
+    void shrink_to_fit() {
+        for_each_column([](auto& column) { column.shrink_to_fit(); });
+    }
+
+    void clear() {
+        for_each_column([](auto& column) { column.clear(); });
+    }
+
+    void push_back(const value_type& val) {
+        std::apply([this](const auto&... fields) { emplace_back(fields...); }, val);
+    }
+
+    void push_back(value_type&& val) {
+        std::apply([this](auto&&... fields) { emplace_back(std::move(fields)...); },
+                   std::move(val));
+    }
+
+    // Takes one constructor argument per field.
+    template <class... Args>
+    reference emplace_back(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Fields),
+                      "emplace_back needs one value per field");
+        emplace_columns(indices(), std::forward<Args>(args)...);
+        return back();
+    }
+
+    void pop_back() {
+        if (empty()) {
+            throw std::exception();
+        }
+        for_each_column([](auto& column) { column.pop_back(); });
+    }
+
+    reference operator[](size_t ind) {
+        return std::apply([&](auto&... column) { return reference(column[ind]...); }, columns_);
+    }
+
+    const_reference operator[](size_t ind) const {
+        return std::apply([&](const auto&... column) { return const_reference(column[ind]...); },
+                          columns_);
+    }
+
+    reference at(size_t ind) {
+        if (ind >= size()) {
+            throw std::out_of_range("soa_vector::at");
+        }
+        return (*this)[ind];
+    }
+
+    const_reference at(size_t ind) const {
+        if (ind >= size()) {
+            throw std::out_of_range("soa_vector::at");
+        }
+        return (*this)[ind];
+    }
+
+    reference front() {
+        return (*this)[0];
+    }
+
+    const_reference front() const {
+        return (*this)[0];
+    }
+
+    reference back() {
+        return (*this)[size() - 1];
+    }
+
+    const_reference back() const {
+        return (*this)[size() - 1];
+    }
+
+    template <size_t I>
+    std::span<field_type<I>> column() {
+        return {std::get<I>(columns_).data(), size()};
+    }
+
+    template <size_t I>
+    std::span<const field_type<I>> column() const {
+        return {std::get<I>(columns_).data(), size()};
+    }
+
+    size_t size() const {
+        return std::get<0>(columns_).size();
+    }
+
+    size_t capacity() const {
+        return std::get<0>(columns_).capacity();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    iterator begin() {
+        return iterator(pointers(), 0);
+    }
+
+    iterator end() {
+        return iterator(pointers(), size());
+    }
+
+    const_iterator begin() const {
+        return const_iterator(pointers(), 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(pointers(), size());
+    }
+
+    void swap(basic_soa_vector& anoth) {
+        columns_.swap(anoth.columns_);
+    }
+
+    bool operator==(const basic_soa_vector& anoth) const {
+        return columns_ == anoth.columns_;
+    }
+
+    bool operator!=(const basic_soa_vector& anoth) const {
+        return !(*this == anoth);
+    }
+
+private:
+    template <class F>
+    void for_each_column(F&& f) {
+        std::apply([&](auto&... column) { (f(column), ...); }, columns_);
+    }
+
+    // Appends to the columns in order; if one throws, the columns before it are popped again.
+    template <size_t... I, class... Args>
+    void emplace_columns(std::index_sequence<I...>, Args&&... args) {
+        size_t pushed = 0;
+        try {
+            ((std::get<I>(columns_).emplace_back(std::forward<Args>(args)), pushed++), ...);
+        } catch (...) {
+            ((I < pushed ? std::get<I>(columns_).pop_back() : void()), ...);
+            throw;
+        }
+    }
+
+    std::tuple<Fields*...> pointers() {
+        return std::apply([](auto&... column) { return std::tuple(column.data()...); }, columns_);
+    }
+
+    std::tuple<const Fields*...> pointers() const {
+        return std::apply([](const auto&... column) { return std::tuple(column.data()...); },
+                          columns_);
+    }
+
+    std::tuple<column_type<Fields>...> columns_;
+};
+
+template <class... Fields>
+using soa_vector = basic_soa_vector<std::allocator<std::byte>, doubling_growth, Fields...>;
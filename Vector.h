@@ -1,436 +1,1177 @@
 #pragma once
 
 #include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstring>
 #include <initializer_list>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <ranges>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #include <vector>
 
-template <class T, class Allocator = std::allocator<T>>
-class my_vector {
-public:
-    class iterator {
-        friend class my_vector<T>;
-
-    public:
-        iterator() = default;
+#include "Error.h"
+#include "Instrument.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+#if defined(MY_VECTOR_DEBUG) && !defined(MY_VECTOR_DEBUG_ITERATORS)
+#define MY_VECTOR_DEBUG_ITERATORS
+#endif
+
+#if defined(MY_VECTOR_DEBUG) && !defined(MY_VECTOR_BOUNDS_CHECK)
+#define MY_VECTOR_BOUNDS_CHECK
+#endif
+
+// Types for which moving an object to a new address and forgetting the old one is equivalent to
+// copying its bytes. Specialize for own types (e.g. ones holding a unique_ptr) to let my_vector
+// grow, insert and erase them with memcpy/memmove. These paths bypass Allocator::construct.
+template <class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+// Growth policies pick the capacity my_vector reallocates to when `required` elements no longer
+// fit into `capacity`. Explicit reserve() calls are not affected.
+template <size_t Num, size_t Den, size_t Initial = 1>
+struct geometric_growth {
+    static_assert(Num > Den, "growth factor must be greater than one");
+
+    template <class T>
+    static size_t next_capacity(size_t capacity, size_t required) {
+        if (capacity == 0) {
+            return std::max(Initial, required);
+        }
+        size_t grown = capacity / Den * Num + capacity % Den * Num / Den;
+        return std::max({grown, capacity + 1, required});
+    }
+};
 
-        iterator(my_vector* obj, size_t ind) : obj_(obj), ind_(ind) {
-        }
+using doubling_growth = geometric_growth<2, 1>;
 
-        iterator operator+(size_t diff) {
-            iterator res = iterator(obj_, ind_ + diff);
-            res.check_correct();
-            return res;
-        }
+// Never allocates less than one cache line worth of elements.
+template <class Base = doubling_growth, size_t CacheLine = 64>
+struct cache_line_growth {
+    template <class T>
+    static size_t next_capacity(size_t capacity, size_t required) {
+        size_t min_capacity = std::max<size_t>(1, CacheLine / sizeof(T));
+        return std::max(Base::template next_capacity<T>(capacity, required), min_capacity);
+    }
+};
 
-        iterator operator-(size_t diff) {
-            iterator res = iterator(obj_, ind_ - diff);
-            res.check_correct();
-            return res;
-        }
+// Rounds capacity up to what glibc malloc really hands out for the request (see
+// malloc_usable_size), so the slack of the chunk becomes usable capacity instead of waste.
+// Meant for allocators that end up in malloc, such as std::allocator.
+template <class Base = geometric_growth<3, 2>>
+struct malloc_size_growth {
+    template <class T>
+    static size_t next_capacity(size_t capacity, size_t required) {
+        size_t wanted = Base::template next_capacity<T>(capacity, required);
+        if (wanted > std::numeric_limits<size_t>::max() / sizeof(T) / 2) {
+            return wanted;
+        }
+        return std::max(wanted, usable_size(wanted * sizeof(T)) / sizeof(T));
+    }
 
-        iterator& operator++() {
-            ind_++;
-            check_correct();
-            return *this;
-        }
-        iterator operator++(int) {
-            iterator res = iterator(obj_, ind_++);
-            check_correct();
-            return res;
-        }
+private:
+    static constexpr size_t header_ = 2 * sizeof(size_t);
+    static constexpr size_t mmap_header_ = 3 * sizeof(size_t);
+    static constexpr size_t mmap_threshold_ = 128 * 1024;
+    static constexpr size_t page_ = 4096;
+
+    static size_t usable_size(size_t bytes) {
+        if (bytes + header_ >= mmap_threshold_) {
+            return (bytes + mmap_header_ + page_ - 1) / page_ * page_ - mmap_header_;
+        }
+        size_t chunk = std::max<size_t>(4 * sizeof(size_t),
+                                        (bytes + sizeof(size_t) + header_ - 1) / header_ * header_);
+        return chunk - sizeof(size_t);
+    }
+};
 
-        iterator& operator--() {
-            ind_--;
-            check_correct();
-            return *this;
-        }
-        iterator operator--(int) {
-            iterator res = iterator(obj_, ind_--);
-            check_correct();
-            return res;
-        }
+template <class T, class Allocator = std::allocator<T>, class GrowthPolicy = doubling_growth>
+class my_vector {
+    using alloc_traits = std::allocator_traits<Allocator>;
 
-        T& operator*() const {
-            check_correct();
-            return obj_->data_[ind_];
-        }
-        T* operator->() const {
-            check_correct();
-            return obj_->data_ + ind_;
-        }
+public:
+    // Iterators are plain pointers unless MY_VECTOR_DEBUG_ITERATORS (or MY_VECTOR_DEBUG) is
+    // defined. Checked iterators throw on out-of-range access and on use after the buffer was
+    // reallocated.
+#ifdef MY_VECTOR_DEBUG_ITERATORS
+    template <class Value>
+    class checked_iterator {
+        friend class my_vector;
+        friend class checked_iterator<const T>;
 
-        bool operator==(const iterator& anoth) const {
-            return obj_ == anoth.obj_ && ind_ == anoth.ind_;
-        }
+        using owner = std::conditional_t<std::is_const_v<Value>, const my_vector, my_vector>;
 
-        bool operator!=(const iterator& anoth) const {
-            return obj_ != anoth.obj_ || ind_ != anoth.ind_;
-        }
+    public:
+        using iterator_concept = std::contiguous_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
 
-        bool operator<(const iterator& anoth) const {
-            check_obj(anoth);
-            return ind_ < anoth.ind_;
-        }
+        checked_iterator() = default;
 
-        bool operator>(const iterator& anoth) const {
-            check_obj(anoth);
-            return ind_ > anoth.ind_;
+        checked_iterator(owner* obj, size_t ind)
+            : obj_(obj), ind_(ind), generation_(obj->generation_) {
         }
 
-        bool operator<=(const iterator& anoth) const {
-            check_obj(anoth);
-            return ind_ <= anoth.ind_;
+        template <class Other>
+        requires(std::is_const_v<Value> && !std::is_const_v<Other>)
+        checked_iterator(const checked_iterator<Other>& anoth)
+            : obj_(anoth.obj_), ind_(anoth.ind_), generation_(anoth.generation_) {
         }
 
-        bool operator>=(const iterator& anoth) const {
-            check_obj(anoth);
-            return ind_ >= anoth.ind_;
+        checked_iterator& operator+=(difference_type diff) {
+            ind_ += diff;
+            check_correct();
+            return *this;
         }
 
-    private:
-        void check_obj(const iterator& anoth) const {
-            if (obj_ != anoth.obj_) {
-                throw std::exception();
-            }
+        checked_iterator& operator-=(difference_type diff) {
+            ind_ -= diff;
+            check_correct();
+            return *this;
         }
 
-        void check_correct() const {
-            if (obj_ == nullptr) {
-                throw std::exception();
-            }
-            if (ind_ > obj_->size_) {
-                throw std::exception();
-            }
+        checked_iterator operator+(difference_type diff) const {
+            checked_iterator res = *this;
+            res += diff;
+            return res;
         }
 
-        my_vector* obj_ = nullptr;
-        size_t ind_ = 0;
-    };
-
-    class const_iterator {
-        friend class my_vector<T>;
-
-    public:
-        const_iterator() = default;
-
-        const_iterator(const my_vector* obj, size_t ind) : obj_(obj), ind_(ind) {
+        friend checked_iterator operator+(difference_type diff, const checked_iterator& it) {
+            return it + diff;
         }
 
-        const_iterator operator+(size_t diff) {
-            const_iterator res = const_iterator(obj_, ind_ + diff);
-            res.check_correct();
+        checked_iterator operator-(difference_type diff) const {
+            checked_iterator res = *this;
+            res -= diff;
             return res;
         }
 
-        const_iterator operator-(size_t diff) {
-            const_iterator res = const_iterator(obj_, ind_ - diff);
-            res.check_correct();
-            return res;
+        difference_type operator-(const checked_iterator& anoth) const {
+            check_obj(anoth);
+            return static_cast<difference_type>(ind_) - static_cast<difference_type>(anoth.ind_);
         }
 
-        const_iterator& operator++() {
+        checked_iterator& operator++() {
             ind_++;
             check_correct();
             return *this;
         }
-        const_iterator operator++(int) {
-            const_iterator res = const_iterator(obj_, ind_++);
-            check_correct();
+
+        checked_iterator operator++(int) {
+            checked_iterator res = *this;
+            ++*this;
             return res;
         }
 
-        const_iterator& operator--() {
+        checked_iterator& operator--() {
             ind_--;
             check_correct();
             return *this;
         }
-        const_iterator operator--(int) {
-            const_iterator res = const_iterator(obj_, ind_--);
-            check_correct();
+
+        checked_iterator operator--(int) {
+            checked_iterator res = *this;
+            --*this;
             return res;
         }
 
-        const T& operator*() const {
+        reference operator*() const {
             check_correct();
             return obj_->data_[ind_];
         }
-        const T* operator->() const {
+
+        pointer operator->() const {
             check_correct();
             return obj_->data_ + ind_;
         }
 
-        bool operator==(const const_iterator& anoth) const {
-            return obj_ == anoth.obj_ && ind_ == anoth.ind_;
-        }
-
-        bool operator!=(const const_iterator& anoth) const {
-            return obj_ != anoth.obj_ || ind_ != anoth.ind_;
+        reference operator[](difference_type diff) const {
+            return *(*this + diff);
         }
 
-        bool operator<(const const_iterator& anoth) const {
-            check_obj(anoth);
-            return ind_ < anoth.ind_;
-        }
-
-        bool operator>(const const_iterator& anoth) const {
-            check_obj(anoth);
-            return ind_ > anoth.ind_;
-        }
-
-        bool operator<=(const const_iterator& anoth) const {
-            check_obj(anoth);
-            return ind_ <= anoth.ind_;
+        bool operator==(const checked_iterator& anoth) const {
+            return obj_ == anoth.obj_ && ind_ == anoth.ind_;
         }
 
-        bool operator>=(const const_iterator& anoth) const {
+        std::strong_ordering operator<=>(const checked_iterator& anoth) const {
             check_obj(anoth);
-            return ind_ >= anoth.ind_;
+            return ind_ <=> anoth.ind_;
         }
 
     private:
-        void check_obj(const const_iterator& anoth) const {
+        void check_obj(const checked_iterator& anoth) const {
             if (obj_ != anoth.obj_) {
-                throw std::exception();
+                vector_fail(vector_status::precondition, "my_vector::iterator");
             }
         }
 
         void check_correct() const {
-            if (obj_ == nullptr) {
-                throw std::exception();
-            }
-            if (ind_ > obj_->size_) {
-                throw std::exception();
+            if (obj_ == nullptr || ind_ > obj_->size_ || generation_ != obj_->generation_) {
+                vector_fail(vector_status::precondition, "my_vector::iterator");
             }
         }
 
-        const my_vector* obj_ = nullptr;
+        owner* obj_ = nullptr;
         size_t ind_ = 0;
+        size_t generation_ = 0;
     };
 
+    using iterator = checked_iterator<T>;
+    using const_iterator = checked_iterator<const T>;
+#else
+    using iterator = T*;
+    using const_iterator = const T*;
+#endif
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
     my_vector() {
     }
 
-    my_vector(const my_vector& anoth) {
-        realloc(anoth.size_, anoth.size_, anoth, anoth.size_);
+    explicit my_vector(const Allocator& alloc) : alloc_(alloc) {
+    }
+
+    my_vector(const my_vector& anoth)
+        : alloc_(alloc_traits::select_on_container_copy_construction(anoth.alloc_)) {
+        assign_copies(anoth.data_, anoth.size_);
+    }
+
+    my_vector(const my_vector& anoth, const Allocator& alloc) : alloc_(alloc) {
+        assign_copies(anoth.data_, anoth.size_);
+    }
+
+    my_vector(my_vector&& anoth) noexcept : alloc_(std::move(anoth.alloc_)) {
+        steal(anoth);
     }
 
-    my_vector(my_vector&& anoth) {
-        swap(anoth);
+    my_vector(my_vector&& anoth, const Allocator& alloc) : alloc_(alloc) {
+        if (alloc_ == anoth.alloc_) {
+            steal(anoth);
+        } else {
+            move_elements_from(anoth);
+        }
     }
 
-    my_vector(size_t size, const T& val = T()) {
+    my_vector(size_t size, const T& val = T(), const Allocator& alloc = Allocator())
+        : alloc_(alloc) {
         realloc(size, size, val);
     }
 
-    my_vector(std::initializer_list<T> list) {
-        realloc(list.size(), list.size(), list, list.size());
+    my_vector(std::initializer_list<T> list, const Allocator& alloc = Allocator()) : alloc_(alloc) {
+        assign_copies(list.begin(), list.size());
+    }
+
+    // Parallel versions of the fill and copy constructors: the buffer is split across the policy's
+    // thread pool, so each thread also takes the first-touch page faults of its piece.
+    my_vector(const parallel_policy& policy, size_t size, const T& val,
+              const Allocator& alloc = Allocator())
+        : alloc_(alloc) {
+        assign(policy, size, val);
+    }
+
+    my_vector(const parallel_policy& policy, const my_vector& anoth)
+        : alloc_(alloc_traits::select_on_container_copy_construction(anoth.alloc_)) {
+        parallel_realloc(policy, anoth.size_, [&](T* dest, size_t first, size_t last) {
+            construct_copies(dest + first, anoth.data_ + first, last - first);
+        });
+    }
+
+    template <std::input_iterator It>
+    my_vector(It first, It last, const Allocator& alloc = Allocator()) : alloc_(alloc) {
+        MY_VECTOR_TRY {
+            if constexpr (std::forward_iterator<It>) {
+                reserve(std::distance(first, last));
+            }
+            insert_range(0, first, last);
+        } MY_VECTOR_CATCH_ALL {
+            release();
+            MY_VECTOR_RETHROW;
+        }
     }
 
     ~my_vector() {
-        clear();
+        note_destroy();
+        release();
     }
 
     my_vector& operator=(const my_vector& anoth) {
-        realloc(anoth.size_, anoth.size_, anoth, anoth.size_);
+        if (this == &anoth) {
+            return *this;
+        }
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+            if (alloc_ != anoth.alloc_) {
+                release();
+            }
+            alloc_ = anoth.alloc_;
+        }
+        assign_copies(anoth.data_, anoth.size_);
         return *this;
     }
 
-    my_vector& operator=(my_vector&& anoth) {
-        clear();
-        swap(anoth);
+    my_vector& operator=(my_vector&& anoth) noexcept(
+        alloc_traits::propagate_on_container_move_assignment::value ||
+        alloc_traits::is_always_equal::value) {
+        if (this == &anoth) {
+            return *this;
+        }
+        release();
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+            alloc_ = std::move(anoth.alloc_);
+            steal(anoth);
+        } else {
+            if (alloc_ == anoth.alloc_) {
+                steal(anoth);
+            } else {
+                move_elements_from(anoth);
+            }
+        }
         return *this;
     }
 
-    void resize(size_t new_size) {
-        realloc(new_size, new_size, *this, std::min(size_, new_size));
+    // Shrinking and growing within capacity never reallocate. Unless the allocator defines its own
+    // construct(), new elements of trivial types are value-initialized in one pass, which the
+    // compiler turns into a memset or a vectorized fill.
+    void resize(size_t new_size) noexcept(nothrow_emplace_<>) {
+        if constexpr (std::is_trivial_v<T> && !custom_construct_) {
+            size_t old_size = size_;
+            resize_uninitialized(new_size);
+            if (new_size > old_size) {
+                std::uninitialized_value_construct_n(data_ + old_size, new_size - old_size);
+                note_constructions(new_size - old_size);
+            }
+        } else {
+            resize_with(new_size, [this](T* ptr) { construct(ptr); });
+        }
+    }
+
+    // Like resize(), but new elements are default-initialized, so trivial types are left
+    // uninitialized. Bypasses Allocator::construct.
+    void resize_default_init(size_t new_size) {
+        resize_with(new_size, [this](T* ptr) {
+            ::new (static_cast<void*>(ptr)) T;
+            note_constructions(1);
+        });
     }
 
-    void reserve(size_t new_capacity) {
+    void resize_uninitialized(size_t new_size)
+    requires std::is_trivial_v<T>
+    {
+        grow_for(new_size);
+        size_ = new_size;
+    }
+
+    // Makes room for new_size elements and calls op(data(), new_size), which fills the buffer and
+    // returns the new size (at most new_size). Elements past the old size are uninitialized when
+    // op starts.
+    template <class Op>
+    requires std::is_trivial_v<T>
+    void resize_and_overwrite(size_t new_size, Op op) {
+        grow_for(new_size);
+        size_t used = std::move(op)(data_, new_size);
+        if (used > new_size) {
+            vector_fail(vector_status::length_error, "my_vector::resize_and_overwrite");
+        }
+        size_ = used;
+    }
+
+    void reserve(size_t new_capacity) noexcept(!vector_exceptions && nothrow_relocate_) {
         if (new_capacity > capacity_) {
-            realloc(size_, new_capacity, *this, size_);
+            relocate(new_capacity);
+        }
+    }
+
+    // reserve() that returns out_of_memory or length_error instead of going through the error
+    // handler, leaving the vector unchanged. Exceptions from T's constructors still propagate.
+    vector_status try_reserve(size_t new_capacity) noexcept(!vector_exceptions &&
+                                                            nothrow_relocate_) {
+        if (new_capacity <= capacity_) {
+            return vector_status::ok;
         }
+        return try_relocate(new_capacity);
     }
 
     void shrink_to_fit() {
-        realloc(size_, size_, *this, size_);
+        if (size_ != capacity_) {
+            relocate(size_);
+        }
     }
 
     void assign(size_t new_size, const T& val) {
         realloc(new_size, new_size, val);
     }
 
-    void push_back(const T& val) {
-        if (size_ == capacity_) {
-            realloc(size_, new_capacity(), *this, size_);
-        }
-        new (data_ + size_) T(val);
-        size_++;
+    void assign(const parallel_policy& policy, size_t new_size, const T& val) {
+        parallel_realloc(policy, new_size, [&](T* dest, size_t first, size_t last) {
+            construct_fill(dest + first, last - first, val);
+        });
+    }
+
+    void push_back(const T& val) noexcept(nothrow_emplace_<const T&>) {
+        emplace_back(val);
+    }
+
+    void push_back(T&& val) noexcept(nothrow_emplace_<T&&>) {
+        emplace_back(std::move(val));
     }
 
     template <class... Args>
-    void emplace_back(Args... args) {
+    T& emplace_back(Args&&... args) noexcept(nothrow_emplace_<Args&&...>) {
         if (size_ == capacity_) {
-            realloc(size_, new_capacity(), *this, size_);
+            realloc_emplace(size_, std::forward<Args>(args)...);
+        } else {
+            construct(data_ + size_, std::forward<Args>(args)...);
+            size_++;
         }
-        new (data_ + size_) T(std::forward<Args>(args)...);
+        return data_[size_ - 1];
+    }
+
+    vector_status try_push_back(const T& val) noexcept(nothrow_try_emplace_<const T&>) {
+        return try_emplace_back(val);
+    }
+
+    vector_status try_push_back(T&& val) noexcept(nothrow_try_emplace_<T&&>) {
+        return try_emplace_back(std::move(val));
+    }
+
+    // emplace_back() that reports a failure to grow as a status, like try_reserve().
+    template <class... Args>
+    vector_status try_emplace_back(Args&&... args) noexcept(nothrow_try_emplace_<Args&&...>) {
+        if (size_ != capacity_) {
+            construct(data_ + size_, std::forward<Args>(args)...);
+            size_++;
+            return vector_status::ok;
+        }
+        // Built first: the arguments may refer into the buffer that growing frees.
+        T val(std::forward<Args>(args)...);
+        if (vector_status status = try_relocate(new_capacity()); status != vector_status::ok) {
+            return status;
+        }
+        construct(data_ + size_, std::move(val));
         size_++;
+        return vector_status::ok;
     }
 
-    void pop_back() {
+    void pop_back() noexcept(!vector_exceptions) {
         if (size_ == 0) {
-            throw std::exception();
+            vector_fail(vector_status::precondition, "my_vector::pop_back");
         }
-        data_[size_].~T();
         size_--;
+        destroy(data_ + size_, data_ + size_ + 1);
+    }
+
+    T& operator[](size_t ind) noexcept(!access_may_throw_) {
+        check_index(ind);
+        return data_[ind];
     }
 
-    T& operator[](size_t ind) {
+    const T& operator[](size_t ind) const noexcept(!access_may_throw_) {
+        check_index(ind);
+        return data_[ind];
+    }
+
+    T& at(size_t ind) {
         if (ind >= size_) {
-            throw std::exception();
+            vector_fail(vector_status::out_of_range, "my_vector::at");
         }
         return data_[ind];
     }
 
-    T operator[](size_t ind) const {
+    const T& at(size_t ind) const {
         if (ind >= size_) {
-            throw std::exception();
+            vector_fail(vector_status::out_of_range, "my_vector::at");
         }
         return data_[ind];
     }
 
-    size_t size() const {
+    size_t size() const noexcept {
         return size_;
     }
 
-    size_t capacity() const {
+    size_t capacity() const noexcept {
         return capacity_;
     }
 
-    bool empty() const {
+#ifdef MY_VECTOR_INSTRUMENT
+    const vector_stats& stats() const {
+        return stats_;
+    }
+#endif
+
+    bool empty() const noexcept {
         return size_ == 0;
     }
 
     Allocator get_allocator() const {
-        return Allocator();
+        return alloc_;
     }
 
-    void swap(my_vector& anoth) {
+    void swap(my_vector& anoth) noexcept {
+        if constexpr (alloc_traits::propagate_on_container_swap::value) {
+            std::swap(alloc_, anoth.alloc_);
+        }
         std::swap(data_, anoth.data_);
         std::swap(size_, anoth.size_);
         std::swap(capacity_, anoth.capacity_);
+        invalidate_iterators();
+        anoth.invalidate_iterators();
     }
 
-    void clear() {
-        for (size_t i = 0; i < size_; ++i) {
-            data_[i].~T();
-        }
-        Allocator().deallocate(data_, capacity_);
-        data_ = nullptr;
-        size_ = 0;
-        capacity_ = 0;
+    void clear() noexcept {
+        note_clear();
+        release();
     }
 
-    T& back() {
-        if (size_ == 0) {
-            throw std::exception();
-        }
+    T& back() noexcept(!access_may_throw_) {
+        check_index(size_ - 1);
         return data_[size_ - 1];
     }
 
-    T back() const {
-        if (size_ == 0) {
-            throw std::exception();
-        }
+    const T& back() const noexcept(!access_may_throw_) {
+        check_index(size_ - 1);
         return data_[size_ - 1];
     }
 
-    T& front() {
-        if (size_ == 0) {
-            throw std::exception();
-        }
+    T& front() noexcept(!access_may_throw_) {
+        check_index(0);
         return data_[0];
     }
 
-    T front() const {
-        if (size_ == 0) {
-            throw std::exception();
-        }
+    const T& front() const noexcept(!access_may_throw_) {
+        check_index(0);
         return data_[0];
     }
 
-    iterator begin() {
-        return iterator(this, 0);
+    iterator begin() noexcept {
+        return make_iterator(0);
+    }
+
+    iterator end() noexcept {
+        return make_iterator(size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return make_iterator(0);
+    }
+
+    const_iterator end() const noexcept {
+        return make_iterator(size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
     }
 
-    iterator end() {
-        return iterator(this, size_);
+    const_iterator cend() const noexcept {
+        return end();
     }
 
-    const_iterator begin() const {
-        return const_iterator(this, 0);
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
     }
 
-    const_iterator end() const {
-        return const_iterator(this, size_);
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
     }
 
-    T* data() {
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    T* data() noexcept {
         return data_;
     }
 
-    const T* data() const {
+    const T* data() const noexcept {
         return data_;
     }
 
-    void insert(iterator it, const T& val) {
-        if (it.ind_ > size_) {
-            throw std::exception();
+    iterator insert(const_iterator it, const T& val) noexcept(nothrow_insert_<const T&>) {
+        return emplace(it, val);
+    }
+
+    iterator insert(const_iterator it, T&& val) noexcept(nothrow_insert_<T&&>) {
+        return emplace(it, std::move(val));
+    }
+
+    template <class... Args>
+    iterator emplace(const_iterator it, Args&&... args) noexcept(nothrow_insert_<Args&&...>) {
+        size_t ind = index_of(it);
+        if (ind > size_) {
+            vector_fail(vector_status::precondition, "my_vector::emplace");
+        }
+        if constexpr (is_trivially_relocatable<T>::value) {
+            relocating_emplace(ind, std::forward<Args>(args)...);
+        } else if (size_ == capacity_) {
+            realloc_emplace(ind, std::forward<Args>(args)...);
+        } else if (ind == size_) {
+            construct(data_ + size_, std::forward<Args>(args)...);
+            size_++;
+        } else {
+            shift_emplace(ind, T(std::forward<Args>(args)...));
+        }
+        return make_iterator(ind);
+    }
+
+    iterator insert(const_iterator it, size_t count,
+                    const T& val) noexcept(nothrow_insert_<const T&>) {
+        size_t ind = index_of(it);
+        if (ind > size_) {
+            vector_fail(vector_status::precondition, "my_vector::insert");
         }
-        emplace_back();
-        std::exception_ptr eptr;
-        size_t exception_index = size_;
-        for (size_t i = size_ - 1; i > it.ind_; --i) {
-            try {
-                data_[i] = data_[i - 1];
-            } catch (...) {
-                eptr = std::current_exception();
-                exception_index = i;
-                break;
+        // val may live in the vector and be shifted away before it is copied.
+        const T copy(val);
+        insert_n(ind, count, [&](T* dest) { construct_fill(dest, count, copy); });
+        return make_iterator(ind);
+    }
+
+    // [first, last) must not point into the vector.
+    template <std::input_iterator It>
+    iterator insert(const_iterator it, It first, It last) {
+        size_t ind = index_of(it);
+        if (ind > size_) {
+            vector_fail(vector_status::precondition, "my_vector::insert");
+        }
+        insert_range(ind, first, last);
+        return make_iterator(ind);
+    }
+
+    iterator insert(const_iterator it, std::initializer_list<T> list) {
+        return insert(it, list.begin(), list.end());
+    }
+
+    template <std::ranges::input_range R>
+    iterator insert_range(const_iterator it, R&& range) {
+        size_t ind = index_of(it);
+        if (ind > size_) {
+            vector_fail(vector_status::precondition, "my_vector::insert_range");
+        }
+        insert_range(ind, std::ranges::begin(range), std::ranges::end(range));
+        return make_iterator(ind);
+    }
+
+    template <std::ranges::input_range R>
+    void append_range(R&& range) {
+        insert_range(size_, std::ranges::begin(range), std::ranges::end(range));
+    }
+
+    iterator erase(const_iterator it) {
+        size_t ind = index_of(it);
+        if (ind >= size_) {
+            vector_fail(vector_status::precondition, "my_vector::erase");
+        }
+        if constexpr (is_trivially_relocatable<T>::value) {
+            destroy(data_ + ind, data_ + ind + 1);
+            move_bytes(data_ + ind, data_ + ind + 1, size_ - ind - 1);
+            size_--;
+            return make_iterator(ind);
+        }
+
+        if constexpr (std::is_nothrow_move_assignable_v<T> || !vector_exceptions) {
+            std::move(data_ + ind + 1, data_ + size_, data_ + ind);
+        } else {
+            copy_shift_left(ind);
+        }
+        pop_back();
+        return make_iterator(ind);
+    }
+
+    // Removes [first, last) with a single shift of the tail.
+    iterator erase(const_iterator first, const_iterator last) {
+        size_t from = index_of(first);
+        size_t to = index_of(last);
+        if (from > to || to > size_) {
+            vector_fail(vector_status::precondition, "my_vector::erase");
+        }
+        if (from == to) {
+            return make_iterator(from);
+        }
+        if constexpr (is_trivially_relocatable<T>::value) {
+            destroy(data_ + from, data_ + to);
+            move_bytes(data_ + from, data_ + to, size_ - to);
+        } else {
+            std::move(data_ + to, data_ + size_, data_ + from);
+            destroy(data_ + size_ - (to - from), data_ + size_);
+        }
+        size_ -= to - from;
+        return make_iterator(from);
+    }
+
+    iterator find(const T& val) {
+        return make_iterator(find_index(val));
+    }
+
+    const_iterator find(const T& val) const {
+        return make_iterator(find_index(val));
+    }
+
+    bool contains(const T& val) const {
+        return find_index(val) != size_;
+    }
+
+    size_t count(const T& val) const {
+        if constexpr (simd_enabled<T>) {
+            return simd_count(data_, size_, val);
+        } else {
+            return std::count(data_, data_ + size_, val);
+        }
+    }
+
+    // Smallest and largest element; throw on an empty vector.
+    T min() const {
+        if (size_ == 0) {
+            vector_fail(vector_status::precondition, "my_vector::min");
+        }
+        if constexpr (simd_enabled<T>) {
+            return simd_min(data_, size_);
+        } else {
+            return *std::min_element(data_, data_ + size_);
+        }
+    }
+
+    T max() const {
+        if (size_ == 0) {
+            vector_fail(vector_status::precondition, "my_vector::max");
+        }
+        if constexpr (simd_enabled<T>) {
+            return simd_max(data_, size_);
+        } else {
+            return *std::max_element(data_, data_ + size_);
+        }
+    }
+
+    bool operator==(const my_vector& anoth) const {
+        if (size_ != anoth.size_) {
+            return false;
+        }
+        if constexpr (simd_enabled<T>) {
+            return simd_equal(data_, anoth.data_, size_);
+        } else {
+            return std::equal(data_, data_ + size_, anoth.data_);
+        }
+    }
+
+    bool operator!=(const my_vector& anoth) const {
+        return !(*this == anoth);
+    }
+
+    // Lexicographic; uses T's operator<=> when it has one and operator< otherwise.
+    auto operator<=>(const my_vector& anoth) const
+    requires requires(const T& val) { val < val; }
+    {
+        using ordering = decltype(synth_three_way(anoth[0], anoth[0]));
+        size_t common = std::min(size_, anoth.size_);
+        if constexpr (simd_enabled<T>) {
+            size_t ind = simd_mismatch(data_, anoth.data_, common);
+            if (ind != common) {
+                return synth_three_way(data_[ind], anoth.data_[ind]);
+            }
+        } else {
+            for (size_t i = 0; i < common; ++i) {
+                if (auto res = synth_three_way(data_[i], anoth.data_[i]); res != 0) {
+                    return res;
+                }
             }
         }
-        if (!eptr) {
-            try {
-                data_[it.ind_] = val;
-            } catch (...) {
-                eptr = std::current_exception();
-                exception_index = it.ind_;
+        return ordering(size_ <=> anoth.size_);
+    }
+
+private:
+    static auto synth_three_way(const T& a, const T& b) {
+        if constexpr (std::three_way_comparable<T>) {
+            return a <=> b;
+        } else {
+            if (a < b) {
+                return std::weak_ordering::less;
             }
+            if (b < a) {
+                return std::weak_ordering::greater;
+            }
+            return std::weak_ordering::equivalent;
         }
-        if (eptr) {
-            try {
-                for (size_t i = exception_index; i + 1 < size_; ++i) {
-                    data_[i] = data_[i + 1];
-                }
-                pop_back();
-            } catch (...) {
+    }
+
+    size_t find_index(const T& val) const {
+        if constexpr (simd_enabled<T>) {
+            return simd_find(data_, size_, val);
+        } else {
+            return std::find(data_, data_ + size_, val) - data_;
+        }
+    }
+
+    void realloc(size_t new_size, size_t new_capacity, const T& val = T()) {
+        if (new_capacity == 0) {
+            release();
+            return;
+        }
+        T* new_data = allocate(new_capacity);
+        MY_VECTOR_TRY {
+            construct_fill(new_data, new_size, val);
+        } MY_VECTOR_CATCH_ALL {
+            deallocate(new_data, new_capacity);
+            MY_VECTOR_RETHROW;
+        }
+
+        release();
+        data_ = new_data;
+        invalidate_iterators();
+        size_ = new_size;
+        capacity_ = new_capacity;
+    }
+
+    // Replaces the contents with copies of [src, src + count) in a buffer of exactly count.
+    void assign_copies(const T* src, size_t count) {
+        if (count == 0) {
+            release();
+            return;
+        }
+        T* new_data = allocate(count);
+        MY_VECTOR_TRY {
+            construct_copies(new_data, src, count);
+        } MY_VECTOR_CATCH_ALL {
+            deallocate(new_data, count);
+            MY_VECTOR_RETHROW;
+        }
+
+        release();
+        data_ = new_data;
+        invalidate_iterators();
+        size_ = count;
+        capacity_ = count;
+    }
+
+    // Replaces the contents with n elements that build(dest, first, last) constructs piecewise
+    // on the policy's threads. If a piece throws, the pieces already built are destroyed and the
+    // vector is left unchanged.
+    template <class Build>
+    void parallel_realloc(const parallel_policy& policy, size_t n, Build build) {
+        if (n == 0) {
+            release();
+            return;
+        }
+        T* new_data = allocate(n);
+        std::mutex mutex;
+        std::vector<std::pair<size_t, size_t>> built;
+        MY_VECTOR_TRY {
+            built.reserve(policy.parts(n, sizeof(T)));
+            policy.for_chunks(n, sizeof(T), [&](size_t first, size_t last) {
+                build(new_data, first, last);
+                std::lock_guard<std::mutex> lock(mutex);
+                built.emplace_back(first, last);
+            });
+        } MY_VECTOR_CATCH_ALL {
+            for (auto [first, last] : built) {
+                destroy(new_data + first, new_data + last);
             }
+            deallocate(new_data, n);
+            MY_VECTOR_RETHROW;
+        }
 
-            std::rethrow_exception(eptr);
+        release();
+        data_ = new_data;
+        invalidate_iterators();
+        size_ = n;
+        capacity_ = n;
+    }
+
+    // Moves own elements into a fresh buffer. Elements are moved only when their move constructor
+    // is noexcept, otherwise they are copied, so a throwing constructor leaves *this untouched.
+    void relocate(size_t new_capacity) {
+        check(try_relocate(new_capacity), "my_vector::reserve");
+    }
+
+    // relocate() that reports allocation failure instead of calling the error handler.
+    vector_status try_relocate(size_t new_capacity) {
+        if (new_capacity == 0) {
+            release();
+            return vector_status::ok;
+        }
+        if constexpr (can_reallocate_) {
+            return try_reallocate(new_capacity);
+        }
+        T* new_data = nullptr;
+        if (vector_status status = try_allocate(new_capacity, new_data);
+            status != vector_status::ok) {
+            return status;
+        }
+        MY_VECTOR_TRY {
+            move_to(new_data, 0, size_);
+        } MY_VECTOR_CATCH_ALL {
+            deallocate(new_data, new_capacity);
+            MY_VECTOR_RETHROW;
+        }
+
+        size_t size = size_;
+        note_realloc(new_capacity, size);
+        release_buffer(size);
+        data_ = new_data;
+        invalidate_iterators();
+        size_ = size;
+        capacity_ = new_capacity;
+        return vector_status::ok;
+    }
+
+    void grow_for(size_t new_size) {
+        if (new_size > capacity_) {
+            relocate(GrowthPolicy::template next_capacity<T>(capacity_, new_size));
+        }
+    }
+
+    // Shrinks, or grows with init(T* ptr) constructing each new element. If init throws, the
+    // elements built so far are destroyed and the size is unchanged.
+    template <class Init>
+    void resize_with(size_t new_size, Init init) {
+        if (new_size <= size_) {
+            destroy(data_ + new_size, data_ + size_);
+            size_ = new_size;
+            return;
+        }
+        grow_for(new_size);
+        size_t constructed = size_;
+        MY_VECTOR_TRY {
+            for (; constructed < new_size; ++constructed) {
+                init(data_ + constructed);
+            }
+        } MY_VECTOR_CATCH_ALL {
+            destroy(data_ + size_, data_ + constructed);
+            MY_VECTOR_RETHROW;
         }
+        size_ = new_size;
     }
 
+    // Builds the new element straight into a grown buffer, then moves the old ones around it.
     template <class... Args>
-    void emplace(iterator it, Args... args) {
-        if (it.ind_ > size_) {
-            throw std::exception();
+    void realloc_emplace(size_t ind, Args&&... args) {
+        if constexpr (can_reallocate_) {
+            relocating_emplace(ind, std::forward<Args>(args)...);
+            return;
+        }
+        realloc_insert(ind, 1, new_capacity(),
+                       [&](T* dest) { construct(dest, std::forward<Args>(args)...); });
+    }
+
+    // Moves the elements into a new buffer of `capacity`, leaving a gap of `count` slots at ind
+    // that fill(T* dest) constructs. fill must clean up after itself when it throws.
+    template <class Fill>
+    void realloc_insert(size_t ind, size_t count, size_t capacity, Fill&& fill) {
+        T* new_data = allocate(capacity);
+        MY_VECTOR_TRY {
+            fill(new_data + ind);
+        } MY_VECTOR_CATCH_ALL {
+            deallocate(new_data, capacity);
+            MY_VECTOR_RETHROW;
+        }
+        MY_VECTOR_TRY {
+            move_to(new_data, 0, ind);
+            MY_VECTOR_TRY {
+                move_to(new_data + ind + count, ind, size_);
+            } MY_VECTOR_CATCH_ALL {
+                destroy(new_data, new_data + ind);
+                MY_VECTOR_RETHROW;
+            }
+        } MY_VECTOR_CATCH_ALL {
+            destroy(new_data + ind, new_data + ind + count);
+            deallocate(new_data, capacity);
+            MY_VECTOR_RETHROW;
+        }
+
+        size_t new_size = size_ + count;
+        note_realloc(capacity, size_);
+        release_buffer(size_);
+        data_ = new_data;
+        invalidate_iterators();
+        size_ = new_size;
+        capacity_ = capacity;
+    }
+
+    // Inserts count elements built by fill at ind with at most one reallocation and one shift of
+    // the tail. Types whose moves may throw always go through a new buffer, so a throwing fill
+    // leaves the vector untouched.
+    template <class Fill>
+    void insert_n(size_t ind, size_t count, Fill&& fill) {
+        if (count == 0) {
+            return;
+        }
+        constexpr bool shift_in_place = is_trivially_relocatable<T>::value ||
+                                        (std::is_nothrow_move_constructible_v<T> &&
+                                         std::is_nothrow_move_assignable_v<T>);
+        if (count > std::numeric_limits<size_t>::max() - size_) {
+            vector_fail(vector_status::length_error, "my_vector: too many elements");
+        }
+        if (size_ + count > capacity_) {
+            size_t capacity = GrowthPolicy::template next_capacity<T>(capacity_, size_ + count);
+            if constexpr (can_reallocate_) {
+                reallocate(capacity);
+            } else {
+                realloc_insert(ind, count, capacity, fill);
+                return;
+            }
+        } else if constexpr (!shift_in_place) {
+            realloc_insert(ind, count, capacity_, fill);
+            return;
+        }
+        open_gap(ind, count);
+        MY_VECTOR_TRY {
+            fill(data_ + ind);
+        } MY_VECTOR_CATCH_ALL {
+            close_gap(ind, count);
+            MY_VECTOR_RETHROW;
+        }
+        size_ += count;
+    }
+
+    template <class It, class Sent>
+    void insert_range(size_t ind, It first, Sent last) {
+        if constexpr (std::forward_iterator<It>) {
+            size_t count = std::ranges::distance(first, last);
+            insert_n(ind, count, [&](T* dest) { construct_copies(dest, first, count); });
+            return;
+        }
+        // The length of single-pass ranges is unknown: append, then rotate into place.
+        size_t old_size = size_;
+        MY_VECTOR_TRY {
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        } MY_VECTOR_CATCH_ALL {
+            destroy(data_ + old_size, data_ + size_);
+            size_ = old_size;
+            MY_VECTOR_RETHROW;
+        }
+        std::rotate(data_ + ind, data_ + old_size, data_ + size_);
+    }
+
+    void construct_fill(T* dest, size_t count, const T& val) {
+        if constexpr (simd_enabled<T>) {
+            simd_fill(dest, count, val);
+            note_constructions(count);
+            return;
+        }
+        size_t i = 0;
+        MY_VECTOR_TRY {
+            for (; i < count; ++i) {
+                construct(dest + i, val);
+            }
+        } MY_VECTOR_CATCH_ALL {
+            destroy(dest, dest + i);
+            MY_VECTOR_RETHROW;
+        }
+    }
+
+    template <class It>
+    void construct_copies(T* dest, It first, size_t count) {
+        if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<It> &&
+                      std::is_same_v<std::iter_value_t<It>, T>) {
+            copy_bytes(dest, std::to_address(first), count);
+            note_constructions(count);
+            return;
+        }
+        size_t i = 0;
+        MY_VECTOR_TRY {
+            for (; i < count; ++i, ++first) {
+                construct(dest + i, *first);
+            }
+        } MY_VECTOR_CATCH_ALL {
+            destroy(dest, dest + i);
+            MY_VECTOR_RETHROW;
+        }
+    }
+
+    // Shifts [ind, size_) right by count, leaving [ind, ind + count) as raw storage. size_ is not
+    // changed. Only used when moving elements cannot throw.
+    void open_gap(size_t ind, size_t count) {
+        if constexpr (is_trivially_relocatable<T>::value) {
+            move_bytes(data_ + ind + count, data_ + ind, size_ - ind);
+            return;
+        }
+        for (size_t i = size_; i-- > ind;) {
+            if (i + count >= size_) {
+                construct(data_ + i + count, std::move(data_[i]));
+            } else {
+                data_[i + count] = std::move(data_[i]);
+            }
         }
-        emplace_back();
+        destroy(data_ + ind, data_ + std::min(ind + count, size_));
+    }
+
+    // Undoes open_gap(ind, count).
+    void close_gap(size_t ind, size_t count) {
+        if constexpr (is_trivially_relocatable<T>::value) {
+            move_bytes(data_ + ind, data_ + ind + count, size_ - ind);
+            return;
+        }
+        for (size_t i = ind; i < size_; ++i) {
+            if (i < ind + count) {
+                construct(data_ + i, std::move(data_[i + count]));
+            } else {
+                data_[i] = std::move(data_[i + count]);
+            }
+        }
+        destroy(data_ + std::max(ind + count, size_), data_ + size_ + count);
+    }
+
+    void move_to(T* dest, size_t first, size_t last) {
+        if constexpr (is_trivially_relocatable<T>::value) {
+            copy_bytes(dest, data_ + first, last - first);
+            return;
+        }
+        size_t i = first;
+        MY_VECTOR_TRY {
+            for (; i < last; ++i) {
+                construct(dest + i - first, std::move_if_noexcept(data_[i]));
+            }
+        } MY_VECTOR_CATCH_ALL {
+            destroy(dest, dest + i - first);
+            MY_VECTOR_RETHROW;
+        }
+    }
+
+    // Opens a gap at ind by shifting the tail one slot to the right and moves val into it. When
+    // move assignment may throw, the tail is shifted by copying so a failure can be rolled back.
+    void shift_emplace(size_t ind, T&& val) {
+        construct(data_ + size_, std::move_if_noexcept(data_[size_ - 1]));
+        size_++;
+        if constexpr (std::is_nothrow_move_assignable_v<T> || !vector_exceptions) {
+            std::move_backward(data_ + ind, data_ + size_ - 2, data_ + size_ - 1);
+            data_[ind] = std::move(val);
+            return;
+        }
+
+#if MY_VECTOR_EXCEPTIONS
         std::exception_ptr eptr;
         size_t exception_index = size_;
-        for (size_t i = size_ - 1; i > it.ind_; --i) {
+        for (size_t i = size_ - 2; i > ind; --i) {
             try {
                 data_[i] = data_[i - 1];
             } catch (...) {
@@ -441,10 +1182,10 @@ public:
         }
         if (!eptr) {
             try {
-                data_[it.ind_] = T(std::forward<Args>(args)...);
+                data_[ind] = std::move(val);
             } catch (...) {
                 eptr = std::current_exception();
-                exception_index = it.ind_;
+                exception_index = ind;
             }
         }
         if (eptr) {
@@ -458,17 +1199,17 @@ public:
 
             std::rethrow_exception(eptr);
         }
+#endif
     }
 
-    void erase(iterator it) {
-        if (it.ind_ >= size_) {
-            throw std::exception();
-        }
-
-        T saved_value = data_[it.ind_];
+    // Shifts (ind, size_) one slot to the left by copy assignment, for types whose moves may
+    // throw. If an assignment throws, the shifted elements are copied back before rethrowing.
+    void copy_shift_left(size_t ind) {
+#if MY_VECTOR_EXCEPTIONS
+        T saved_value = data_[ind];
         std::exception_ptr eptr;
         size_t exception_index = size_;
-        for (size_t i = it.ind_; i + 1 < size_; ++i) {
+        for (size_t i = ind; i + 1 < size_; ++i) {
             try {
                 data_[i] = data_[i + 1];
             } catch (...) {
@@ -479,96 +1220,419 @@ public:
         }
         if (eptr) {
             try {
-                for (size_t i = exception_index; i > it.ind_; --i) {
+                for (size_t i = exception_index; i > ind; --i) {
                     data_[i] = data_[i - 1];
                 }
-                data_[it.ind_] = saved_value;
+                data_[ind] = saved_value;
             } catch (...) {
             }
 
             std::rethrow_exception(eptr);
         }
-        pop_back();
+#endif
     }
 
-    bool operator==(const my_vector& anoth) const {
-        if (size_ != anoth.size_) {
-            return false;
+    // Frees the buffer after its first `moved` elements were transferred by move_to().
+    void release_buffer(size_t moved) {
+        if constexpr (is_trivially_relocatable<T>::value) {
+            destroy(data_ + moved, data_ + size_);
+            deallocate(data_, capacity_);
+            data_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+        } else {
+            release();
+        }
+    }
+
+    template <class... Args>
+    void relocating_emplace(size_t ind, Args&&... args) {
+        if (size_ == capacity_ && !can_reallocate_) {
+            size_t capacity = new_capacity();
+            T* new_data = allocate(capacity);
+            MY_VECTOR_TRY {
+                construct(new_data + ind, std::forward<Args>(args)...);
+            } MY_VECTOR_CATCH_ALL {
+                deallocate(new_data, capacity);
+                MY_VECTOR_RETHROW;
+            }
+            copy_bytes(new_data, data_, ind);
+            copy_bytes(new_data + ind + 1, data_ + ind, size_ - ind);
+            note_realloc(capacity, size_);
+            deallocate(data_, capacity_);
+            data_ = new_data;
+            invalidate_iterators();
+            size_++;
+            capacity_ = capacity;
+            return;
         }
-        for (size_t i = 0; i < size_; ++i) {
-            if (data_[i] != anoth.data_[i]) {
-                return false;
+
+        // The value is built aside first, so arguments referring into the vector stay valid.
+        alignas(T) unsigned char buffer[sizeof(T)];
+        T* val = new (buffer) T(std::forward<Args>(args)...);
+        note_constructions(1);
+        if constexpr (can_reallocate_) {
+            if (size_ == capacity_) {
+                MY_VECTOR_TRY {
+                    reallocate(new_capacity());
+                } MY_VECTOR_CATCH_ALL {
+                    val->~T();
+                    MY_VECTOR_RETHROW;
+                }
             }
         }
+        move_bytes(data_ + ind + 1, data_ + ind, size_ - ind);
+        copy_bytes(data_ + ind, val, 1);
+        size_++;
+    }
 
-        return true;
+    // Allocators may provide T* reallocate(T* ptr, size_t old_n, size_t new_n) that resizes a
+    // buffer in place or by remapping it (see MmapAllocator.h). Trivially relocatable elements
+    // are grown through it instead of being copied to a fresh buffer.
+    static constexpr bool can_reallocate_ =
+        is_trivially_relocatable<T>::value && requires(Allocator& alloc, T* ptr, size_t n) {
+            alloc.reallocate(ptr, n, n);
+        };
+
+    void reallocate(size_t new_capacity) {
+        check(try_reallocate(new_capacity), "my_vector::reserve");
     }
 
-    bool operator!=(const my_vector& anoth) const {
-        if (size_ != anoth.size_) {
-            return true;
-        }
-        for (size_t i = 0; i < size_; ++i) {
-            if (data_[i] != anoth.data_[i]) {
-                return true;
+    vector_status try_reallocate(size_t new_capacity) {
+        if (data_ == nullptr) {
+            if (vector_status status = try_allocate(new_capacity, data_);
+                status != vector_status::ok) {
+                return status;
             }
+        } else {
+            if (new_capacity > alloc_traits::max_size(alloc_)) {
+                return vector_status::length_error;
+            }
+            T* new_data = nullptr;
+            if (vector_status status = guarded_allocation(
+                    new_data, [&] { return alloc_.reallocate(data_, capacity_, new_capacity); });
+                status != vector_status::ok) {
+                return status;
+            }
+            note_realloc(new_capacity, size_);
+            data_ = new_data;
         }
+        capacity_ = new_capacity;
+        invalidate_iterators();
+        return vector_status::ok;
+    }
 
-        return false;
+    static void copy_bytes(T* dest, const T* src, size_t count) {
+        if (count != 0) {
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(src), count * sizeof(T));
+        }
     }
 
-private:
-    void realloc(size_t new_size, size_t new_capacity, const T& val = T()) {
-        if (new_capacity == 0) {
-            clear();
-            return;
+    static void move_bytes(T* dest, const T* src, size_t count) {
+        if (count != 0) {
+            std::memmove(static_cast<void*>(dest), static_cast<const void*>(src), count * sizeof(T));
         }
-        T* new_data = Allocator().allocate(new_capacity);
-        for (int i = 0; i < new_size; ++i) {
-            new (new_data + i) T(val);
+    }
+
+    static constexpr bool custom_construct_ = requires(Allocator& alloc, T* ptr) {
+        alloc.construct(ptr);
+    };
+
+    // Growing moves the elements with move_if_noexcept, or copies their bytes.
+    static constexpr bool nothrow_relocate_ =
+        is_trivially_relocatable<T>::value ||
+        std::is_nothrow_constructible_v<T, decltype(std::move_if_noexcept(std::declval<T&>()))>;
+
+    // Without exceptions a failure ends the program, so a mutator throws only if T does.
+    template <class... Args>
+    static constexpr bool nothrow_emplace_ =
+        !vector_exceptions && nothrow_relocate_ && std::is_nothrow_constructible_v<T, Args...>;
+
+    // Inserting before the end also moves the tail and assigns into the gap.
+    template <class... Args>
+    static constexpr bool nothrow_insert_ =
+        nothrow_emplace_<Args...> &&
+        (is_trivially_relocatable<T>::value ||
+         (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>));
+
+    // try_emplace_back() also moves a value built aside into the grown buffer. With exceptions
+    // the allocator, the error handler or an instrument hook may still throw.
+    template <class... Args>
+    static constexpr bool nothrow_try_emplace_ =
+        nothrow_emplace_<Args...> && std::is_nothrow_move_constructible_v<T>;
+
+    // operator[], front() and back() are unchecked unless MY_VECTOR_BOUNDS_CHECK (or
+    // MY_VECTOR_DEBUG) is defined; at() always checks.
+#ifdef MY_VECTOR_BOUNDS_CHECK
+    static constexpr bool access_may_throw_ = vector_exceptions;
+#else
+    static constexpr bool access_may_throw_ = false;
+#endif
+
+    void check_index([[maybe_unused]] size_t ind) const noexcept(!access_may_throw_) {
+#ifdef MY_VECTOR_BOUNDS_CHECK
+        if (ind >= size_) {
+            vector_fail(vector_status::out_of_range, "my_vector: index out of range");
         }
+#endif
+    }
 
-        clear();
-        data_ = new_data;
-        size_ = new_size;
-        capacity_ = new_capacity;
+#ifdef MY_VECTOR_DEBUG_ITERATORS
+    iterator make_iterator(size_t ind) {
+        return iterator(this, ind);
     }
 
-    template <class C>
-    void realloc(size_t new_size, size_t new_capacity, const C& copy_from, size_t copy_size) {
-        if (new_capacity == 0) {
-            clear();
+    const_iterator make_iterator(size_t ind) const {
+        return const_iterator(this, ind);
+    }
+
+    size_t index_of(const const_iterator& it) const {
+        if (it.obj_ != this || it.generation_ != generation_) {
+            vector_fail(vector_status::precondition, "my_vector::iterator");
+        }
+        return it.ind_;
+    }
+
+    // Bumped whenever the buffer changes, so iterators into the old one are detected as stale.
+    void invalidate_iterators() {
+        generation_++;
+    }
+#else
+    iterator make_iterator(size_t ind) {
+        return data_ + ind;
+    }
+
+    const_iterator make_iterator(size_t ind) const {
+        return data_ + ind;
+    }
+
+    size_t index_of(const_iterator it) const {
+        return it - data_;
+    }
+
+    void invalidate_iterators() {
+    }
+#endif
+
+    // Destroys the elements and frees the buffer; clear() without the instrumentation event.
+    void release() {
+        destroy(data_, data_ + size_);
+        deallocate(data_, capacity_);
+        data_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+        invalidate_iterators();
+    }
+
+#ifdef MY_VECTOR_INSTRUMENT
+    void note_event(vector_event event, size_t new_capacity, size_t bytes_moved) const {
+        vector_instrument::global().fire(
+            {event, this, sizeof(T), size_, capacity_, new_capacity, bytes_moved});
+    }
+
+    void note_clear() const {
+        note_event(vector_event::clear, 0, 0);
+    }
+
+    void note_destroy() const {
+        note_event(vector_event::destroy, 0, 0);
+    }
+
+    void note_capacity(size_t capacity) {
+        stats_.peak_capacity = std::max(stats_.peak_capacity, capacity);
+        vector_instrument::global().note_capacity(capacity * sizeof(T));
+    }
+
+    void note_allocate(size_t n) {
+        stats_.allocations++;
+        vector_instrument::global().allocations++;
+        note_capacity(n);
+    }
+
+    void note_deallocate() {
+        stats_.deallocations++;
+        vector_instrument::global().deallocations++;
+    }
+
+    // Counted atomically: parallel bulk operations construct from several threads.
+    void note_constructions(size_t count) {
+        std::atomic_ref<size_t>(stats_.constructions).fetch_add(count, std::memory_order_relaxed);
+        vector_instrument::global().constructions.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Called before the buffer is replaced by one of new_capacity, `moved` elements carried over.
+    // The first buffer of an empty vector is not a reallocation.
+    void note_realloc(size_t new_capacity, size_t moved) {
+        if (capacity_ == 0) {
             return;
         }
-        T* new_data = Allocator().allocate(new_capacity);
-        auto it = copy_from.begin();
-        for (size_t i = 0; i < copy_size; ++i) {
-            new (new_data + i) T(*it);
-            ++it;
+        stats_.reallocations++;
+        stats_.bytes_moved += moved * sizeof(T);
+        vector_instrument::global().reallocations++;
+        vector_instrument::global().bytes_moved += moved * sizeof(T);
+        note_capacity(new_capacity);
+        note_event(vector_event::reallocate, new_capacity, moved * sizeof(T));
+    }
+#else
+    void note_clear() const {
+    }
+
+    void note_destroy() const {
+    }
+
+    void note_allocate(size_t) {
+    }
+
+    void note_deallocate() {
+    }
+
+    void note_constructions(size_t) {
+    }
+
+    void note_realloc(size_t, size_t) {
+    }
+#endif
+
+    void steal(my_vector& anoth) {
+        data_ = anoth.data_;
+        size_ = anoth.size_;
+        capacity_ = anoth.capacity_;
+        anoth.data_ = nullptr;
+        anoth.size_ = 0;
+        anoth.capacity_ = 0;
+        invalidate_iterators();
+        anoth.invalidate_iterators();
+    }
+
+    void move_elements_from(my_vector& anoth) {
+        reserve(anoth.size_);
+        for (size_t i = 0; i < anoth.size_; ++i) {
+            emplace_back(std::move(anoth.data_[i]));
         }
-        for (size_t i = copy_size; i < new_size; ++i) {
-            new (new_data + i) T();
+        anoth.release();
+    }
+
+    T* allocate(size_t n) {
+        T* res = nullptr;
+        check(try_allocate(n, res), "my_vector::allocate");
+        return res;
+    }
+
+    // Leaves res untouched on failure. Without exceptions std::allocator is bypassed for nothrow
+    // operator new (the memory is compatible with its deallocate), and other allocators report
+    // failure by returning nullptr.
+    vector_status try_allocate(size_t n, T*& res) {
+        if (n > alloc_traits::max_size(alloc_)) {
+            return vector_status::length_error;
+        }
+        T* ptr = nullptr;
+        vector_status status = guarded_allocation(ptr, [&] {
+            if constexpr (!vector_exceptions && std::is_same_v<Allocator, std::allocator<T>>) {
+                if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                    return static_cast<T*>(::operator new(
+                        n * sizeof(T), std::align_val_t(alignof(T)), std::nothrow));
+                } else {
+                    return static_cast<T*>(::operator new(n * sizeof(T), std::nothrow));
+                }
+            } else {
+                return alloc_traits::allocate(alloc_, n);
+            }
+        });
+        if (status == vector_status::ok) {
+            res = ptr;
+            note_allocate(n);
         }
+        return status;
+    }
 
-        clear();
-        data_ = new_data;
-        size_ = new_size;
-        capacity_ = new_capacity;
+    // Runs an allocator call, turning std::bad_alloc or a nullptr result into a status.
+    template <class Call>
+    static vector_status guarded_allocation(T*& res, Call call) {
+#if MY_VECTOR_EXCEPTIONS
+        try {
+            res = call();
+        } catch (const std::bad_alloc&) {
+            return vector_status::out_of_memory;
+        }
+#else
+        res = call();
+#endif
+        return res != nullptr ? vector_status::ok : vector_status::out_of_memory;
     }
 
-    static const int factor_;
+    static void check(vector_status status, const char* where) {
+        if (status != vector_status::ok) {
+            vector_fail(status, where);
+        }
+    }
 
-    size_t new_capacity() {
-        if (capacity_ == 0) {
-            return 1;
+    void deallocate(T* ptr, size_t n) {
+        if (ptr != nullptr) {
+            alloc_traits::deallocate(alloc_, ptr, n);
+            note_deallocate();
+        }
+    }
+
+    template <class... Args>
+    void construct(T* ptr, Args&&... args) {
+        alloc_traits::construct(alloc_, ptr, std::forward<Args>(args)...);
+        note_constructions(1);
+    }
+
+    void destroy(T* first, T* last) {
+        for (; first != last; ++first) {
+            alloc_traits::destroy(alloc_, first);
         }
-        return capacity_ * factor_;
     }
 
+    size_t new_capacity() {
+        return GrowthPolicy::template next_capacity<T>(capacity_, size_ + 1);
+    }
+
+    [[no_unique_address]] Allocator alloc_;
     T* data_ = nullptr;
     size_t size_ = 0;
     size_t capacity_ = 0;
+#ifdef MY_VECTOR_DEBUG_ITERATORS
+    size_t generation_ = 0;
+#endif
+#ifdef MY_VECTOR_INSTRUMENT
+    vector_stats stats_;
+#endif
 };
 
-template <class T, class A>
-const int my_vector<T, A>::factor_ = 2;
\ No newline at end of file
+// Compacts the kept elements in one pass and trims the tail; returns the number removed.
+template <class T, class Allocator, class GrowthPolicy, class Pred>
+size_t erase_if(my_vector<T, Allocator, GrowthPolicy>& vec, Pred pred) {
+    auto it = std::remove_if(vec.begin(), vec.end(), pred);
+    size_t removed = vec.end() - it;
+    vec.erase(it, vec.end());
+    return removed;
+}
+
+template <class T, class Allocator, class GrowthPolicy, class U>
+size_t erase(my_vector<T, Allocator, GrowthPolicy>& vec, const U& val) {
+    return erase_if(vec, [&](const T& elem) { return elem == val; });
+}
+
+template <class T, class Allocator, class GrowthPolicy, class F>
+void parallel_for_each(const parallel_policy& policy, my_vector<T, Allocator, GrowthPolicy>& vec,
+                       F f) {
+    T* data = vec.data();
+    policy.for_chunks(vec.size(), sizeof(T), [&](size_t first, size_t last) {
+        std::for_each(data + first, data + last, f);
+    });
+}
+
+// dst[i] = f(src[i]) on the policy's threads. dst is resized with resize_default_init(), so for
+// trivial types its new pages are first touched by the threads that write them.
+template <class T, class A1, class G1, class U, class A2, class G2, class F>
+void parallel_transform(const parallel_policy& policy, const my_vector<T, A1, G1>& src,
+                        my_vector<U, A2, G2>& dst, F f) {
+    dst.resize_default_init(src.size());
+    const T* from = src.data();
+    U* to = dst.data();
+    policy.for_chunks(src.size(), std::max(sizeof(T), sizeof(U)), [&](size_t first, size_t last) {
+        std::transform(from + first, from + last, to + first, f);
+    });
+}
@@ -0,0 +1,843 @@
+#include <vector>
+#include "Vector.h"
+#include "Arena.h"
+#include "SmallVector.h"
+#include "MmapAllocator.h"
+#include "SoaVector.h"
+#include "ConcurrentVector.h"
+#include "MmapVector.h"
+#include "Serialize.h"
+#include "CowVector.h"
+#include "PersistentVector.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+using std::vector;
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC pairs operator new with operator delete only and flags the inlined free() as a mismatch,
+// although both replacements go through malloc.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#pragma GCC diagnostic pop
+
+// Peak resident set size in MiB since the last reset_peak_rss() (Linux only).
+size_t peak_rss() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::strtoull(line.c_str() + 6, nullptr, 10) >> 10;
+        }
+    }
+    return 0;
+}
+
+void reset_peak_rss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+template <class F>
+void run(const char* name, F f) {
+    size_t allocations_before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto finish = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(finish - start).count();
+    std::printf("%-48s %10.3f ms %12zu allocs\n", name, ms, allocations - allocations_before);
+}
+
+template <class V>
+void push_back_strings(size_t n) {
+    V v;
+    std::string s(32, 'x');
+    for (size_t i = 0; i < n; ++i) {
+        v.push_back(s);
+    }
+}
+
+template <class V>
+void insert_erase_middle(size_t n, size_t ops) {
+    V v(n, 1);
+    for (size_t i = 0; i < ops; ++i) {
+        v.insert(v.begin() + n / 2, 2);
+    }
+    for (size_t i = 0; i < ops; ++i) {
+        v.erase(v.begin() + n / 2);
+    }
+}
+
+// Ingests batches of records either one push_back at a time or with a single bulk insert, then
+// drops every other batch.
+template <class V>
+void batch_ingest(size_t batches, size_t batch_size, bool bulk) {
+    V batch(batch_size, 7);
+    V v;
+    for (size_t b = 0; b < batches; ++b) {
+        if (bulk) {
+            v.insert(v.begin() + v.size() / 2, batch.begin(), batch.end());
+        } else {
+            for (size_t i = 0; i < batch_size; ++i) {
+                v.insert(v.begin() + v.size() / 2, batch[i]);
+            }
+        }
+    }
+    for (size_t b = 0; b < batches / 2; ++b) {
+        v.erase(v.begin() + b * batch_size, v.begin() + (b + 1) * batch_size);
+    }
+}
+
+template <class V, class... Alloc>
+void small_vectors(size_t requests, size_t vectors, size_t elements, Alloc&... alloc) {
+    for (size_t r = 0; r < requests; ++r) {
+        for (size_t i = 0; i < vectors; ++i) {
+            V v(alloc...);
+            for (size_t j = 0; j < elements; ++j) {
+                v.push_back(j);
+            }
+        }
+        (alloc.release(), ...);
+    }
+}
+
+template <class V>
+void push_back_ints(size_t n) {
+    V v;
+    for (size_t i = 0; i < n; ++i) {
+        v.push_back(i);
+    }
+    std::printf("    capacity %zu MiB for %zu MiB of data\n", v.capacity() * sizeof(int) >> 20,
+                v.size() * sizeof(int) >> 20);
+}
+
+template <class V>
+void sum_transform(size_t n, size_t rounds) {
+    V v(n, 1);
+    unsigned long long sum = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (auto& x : v) {
+            x = x * 3 + 1;
+        }
+        for (auto it = v.begin(); it != v.end(); ++it) {
+            sum += *it;
+        }
+    }
+    std::printf("    sum %llu\n", sum);
+}
+
+template <class V>
+void random_access(size_t n, size_t reads) {
+    V v(n, 1);
+    unsigned long long sum = 0;
+    size_t ind = 0;
+    for (size_t i = 0; i < reads; ++i) {
+        ind = (ind * 1103515245 + 12345) % n;
+        sum += v[ind];
+    }
+    std::printf("    sum %llu\n", sum);
+}
+
+// random_access() over a table too large for the TLB, also reporting huge-page backing.
+template <class V>
+void random_lookup(size_t n, size_t reads) {
+    V v(n, 1);
+    unsigned long long sum = 0;
+    size_t ind = 0;
+    for (size_t i = 0; i < reads; ++i) {
+        ind = (ind * 1103515245 + 12345) % n;
+        sum += v[ind];
+    }
+    std::printf("    sum %llu, %zu MiB on huge pages, %zu advise / %zu NUMA failures\n", sum,
+                anon_huge_page_bytes() >> 20, huge_page_stats().advise_failures.load(),
+                huge_page_stats().numa_failures.load());
+}
+
+// Stands in for read(2): opaque to the optimizer, so zeroing before it cannot be elided.
+[[gnu::noinline]] void read_into(unsigned char* dest, const unsigned char* src, size_t n) {
+    std::memcpy(dest, src, n);
+}
+
+// Refills a reused buffer with n bytes of "file" data per round.
+template <class V, class Resize>
+void refill_buffer(size_t n, size_t rounds, Resize resize) {
+    std::vector<unsigned char> src(n, 42);
+    V v;
+    unsigned long long sum = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        v.resize(0);
+        resize(v, n);
+        read_into(v.data(), src.data(), n);
+        sum += v[r % n];
+    }
+    std::printf("    sum %llu\n", sum);
+}
+
+// Compares `pairs` pairs of vectors that differ only in their last element, then scans them.
+template <class V>
+void compare_scan(size_t pairs, size_t n, size_t rounds) {
+    std::vector<V> a(pairs, V(n, 7));
+    std::vector<V> b = a;
+    for (V& v : b) {
+        v.back() = 8;
+    }
+    size_t equal = 0;
+    size_t found = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < pairs; ++i) {
+            equal += a[i] == b[i];
+            equal += a[i] < b[i];
+            found += std::count(b[i].begin(), b[i].end(), 8u);
+            found += *std::max_element(b[i].begin(), b[i].end());
+        }
+    }
+    std::printf("    equal %zu found %zu\n", equal, found);
+}
+
+template <class V>
+void compare_scan_members(size_t pairs, size_t n, size_t rounds) {
+    std::vector<V> a(pairs, V(n, 7));
+    std::vector<V> b = a;
+    for (V& v : b) {
+        v.back() = 8;
+    }
+    size_t equal = 0;
+    size_t found = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < pairs; ++i) {
+            equal += a[i] == b[i];
+            equal += a[i] < b[i];
+            found += b[i].count(8u);
+            found += b[i].max();
+        }
+    }
+    std::printf("    equal %zu found %zu\n", equal, found);
+}
+
+// Fill-constructs, copies and transforms n ints through a pool of `threads` threads.
+void parallel_bulk(size_t n, size_t threads) {
+    thread_pool pool(threads);
+    parallel_policy policy{&pool};
+    my_vector<int> a(policy, n, 3);
+    my_vector<int> b(policy, a);
+    parallel_for_each(policy, b, [](int& x) { x = x * 7 + 1; });
+    my_vector<long long> c;
+    parallel_transform(policy, b, c, [](int x) { return static_cast<long long>(x) * x; });
+    std::printf("    %zu threads, c[n / 2] %lld\n", threads, c[n / 2]);
+}
+
+// `threads` threads each append n / threads ints to one shared vector.
+template <class Push>
+void shared_append(size_t n, size_t threads, Push push) {
+    my_vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = t; i < n; i += threads) {
+                push(static_cast<int>(i));
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void concurrent_append(size_t n, size_t threads) {
+    concurrent_vector<int> v;
+    shared_append(n, threads, [&](int x) { v.push_back(x); });
+    std::printf("    %zu threads, size %zu\n", threads, v.size());
+}
+
+void locked_append(size_t n, size_t threads) {
+    my_vector<int> v;
+    std::mutex mutex;
+    shared_append(n, threads, [&](int x) {
+        std::lock_guard<std::mutex> lock(mutex);
+        v.push_back(x);
+    });
+    std::printf("    %zu threads, size %zu\n", threads, v.size());
+}
+
+struct Record {
+    double price;
+    int quantity;
+    long long id;
+    char name[40];
+};
+
+using RecordColumns = soa_vector<double, int, long long, std::array<char, 40>>;
+
+void fill_records(my_vector<Record>& aos, RecordColumns& soa, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        aos.push_back({i * 0.5, static_cast<int>(i), static_cast<long long>(i), {}});
+        soa.emplace_back(i * 0.5, static_cast<int>(i), static_cast<long long>(i),
+                         std::array<char, 40>{});
+    }
+}
+
+// Sums field(element) over the range, `rounds` times.
+template <class Range, class Field>
+void scan_field(const Range& range, size_t rounds, Field field) {
+    double sum = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (const auto& elem : range) {
+            sum += field(elem);
+        }
+    }
+    std::printf("    sum %.0f\n", sum);
+}
+
+// Startup cost of a table of n records kept in a file: reading it back record by record into a
+// my_vector, or mapping it.
+void save_records(const std::string& path, size_t n) {
+    std::remove(path.c_str());
+    mmap_vector<Record> table(path);
+    table.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        table.push_back({i * 0.5, static_cast<int>(i), static_cast<long long>(i), {}});
+    }
+    table.flush();
+}
+
+void stream_load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(sizeof(mmap_vector_header));
+    my_vector<Record> table;
+    Record record;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        table.push_back(record);
+    }
+    std::printf("    %zu records, last id %lld\n", table.size(), table.back().id);
+}
+
+void mmap_load(const std::string& path) {
+    const mmap_vector<Record> table(path, mmap_mode::read_only);
+    std::printf("    %zu records, last id %lld\n", table.size(), table.back().id);
+}
+
+// Saves and loads n ints through a file stream, as one block or element by element.
+void save_load(const std::string& path, size_t n, bool block) {
+    my_vector<int> v(n, 5);
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (block) {
+            write_vector(out, v);
+        } else {
+            for (int x : v) {
+                out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+            }
+        }
+    }
+    my_vector<int> back;
+    std::ifstream in(path, std::ios::binary);
+    if (block) {
+        read_vector(in, back);
+    } else {
+        int x;
+        while (in.read(reinterpret_cast<char*>(&x), sizeof(x))) {
+            back.push_back(x);
+        }
+    }
+    std::printf("    %zu ints back\n", back.size());
+}
+
+// Takes `requests` snapshots of an n-element table and reads one element from each.
+template <class V>
+void snapshots(size_t n, size_t requests) {
+    V table(n, 1);
+    size_t sum = 0;
+    for (size_t r = 0; r < requests; ++r) {
+        const V snapshot = table;
+        sum += snapshot[r % n];
+    }
+    std::printf("    sum %zu\n", sum);
+}
+
+my_vector<int> edit_copy(const my_vector<int>& table, size_t ind, int val) {
+    my_vector<int> res = table;
+    res[ind] = val;
+    return res;
+}
+
+persistent_vector<int> edit_copy(const persistent_vector<int>& table, size_t ind, int val) {
+    return table.set(ind, val);
+}
+
+// Keeps `count` versions of an n-element table, each differing from the previous in one element.
+template <class V>
+void versions(size_t n, size_t count) {
+    reset_peak_rss();
+    my_vector<V> history;
+    history.push_back(V(my_vector<int>(n, 1)));
+    for (size_t v = 1; v < count; ++v) {
+        history.push_back(edit_copy(history.back(), v * 7919 % n, static_cast<int>(v)));
+    }
+    std::printf("    %zu versions, peak RSS %zu MiB\n", history.size(), peak_rss());
+}
+
+template <class V>
+void grow_huge(size_t n) {
+    reset_peak_rss();
+    {
+        V v;
+        for (size_t i = 0; i < n; ++i) {
+            v.push_back(i);
+        }
+    }
+    std::printf("    peak RSS %zu MiB for %zu MiB of data\n", peak_rss(), n * sizeof(int) >> 20);
+}
+
+// Microbenchmark suite: every case runs on my_vector and std::vector, `repetitions` times each,
+// and reports the median time per item side by side. Results can also be written as JSON.
+
+struct Blob {
+    char bytes[256];
+
+    bool operator==(const Blob&) const = default;
+};
+
+template <class T>
+T make_item(size_t i);
+
+template <>
+int make_item<int>(size_t i) {
+    return static_cast<int>(i);
+}
+
+// Long enough to live on the heap rather than in the small-string buffer.
+template <>
+std::string make_item<std::string>(size_t i) {
+    std::string str = "item-" + std::to_string(i);
+    str.resize(24, '.');
+    return str;
+}
+
+template <>
+Blob make_item<Blob>(size_t i) {
+    Blob blob{};
+    blob.bytes[0] = static_cast<char>(i);
+    return blob;
+}
+
+size_t digest(int x) {
+    return x;
+}
+
+size_t digest(const std::string& str) {
+    return str.size();
+}
+
+size_t digest(const Blob& blob) {
+    return blob.bytes[0];
+}
+
+// Keeps the optimizer from dropping a result.
+template <class T>
+void keep(const T& val) {
+    asm volatile("" : : "r"(&val) : "memory");
+}
+
+struct timing {
+    double ns;
+    size_t items;
+};
+
+template <class F>
+double elapsed_ns(F body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(finish - start).count();
+}
+
+template <class V>
+V make_filled(size_t n) {
+    V v;
+    for (size_t i = 0; i < n; ++i) {
+        v.push_back(make_item<typename V::value_type>(i));
+    }
+    return v;
+}
+
+template <class V>
+timing micro_push_back(size_t n) {
+    V items = make_filled<V>(n);
+    V v;
+    double ns = elapsed_ns([&] {
+        for (size_t i = 0; i < n; ++i) {
+            v.push_back(items[i]);
+        }
+    });
+    keep(v);
+    return {ns, n};
+}
+
+template <class V>
+timing micro_emplace_back(size_t n) {
+    V items = make_filled<V>(n);
+    V v;
+    double ns = elapsed_ns([&] {
+        for (size_t i = 0; i < n; ++i) {
+            v.emplace_back(std::move(items[i]));
+        }
+    });
+    keep(v);
+    return {ns, n};
+}
+
+template <class V>
+timing micro_reserve_fill(size_t n) {
+    V items = make_filled<V>(n);
+    V v;
+    double ns = elapsed_ns([&] {
+        v.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            v.push_back(items[i]);
+        }
+    });
+    keep(v);
+    return {ns, n};
+}
+
+template <class V>
+timing micro_iterate(size_t n) {
+    V v = make_filled<V>(n);
+    size_t sum = 0;
+    double ns = elapsed_ns([&] {
+        for (const auto& val : v) {
+            sum += digest(val);
+        }
+    });
+    keep(sum);
+    return {ns, n};
+}
+
+template <class V>
+timing micro_random_access(size_t n) {
+    V v = make_filled<V>(n);
+    size_t sum = 0;
+    size_t ind = 0;
+    double ns = elapsed_ns([&] {
+        for (size_t i = 0; i < n; ++i) {
+            ind = (ind * 1103515245 + 12345) % n;
+            sum += digest(v[ind]);
+        }
+    });
+    keep(sum);
+    return {ns, n};
+}
+
+// Inserts and erases one element at `where` (0 = front, 1 = middle, 2 = back), 256 times.
+template <class V, int Where>
+timing micro_insert_erase(size_t n) {
+    V v = make_filled<V>(n);
+    auto item = make_item<typename V::value_type>(n);
+    const size_t ops = 256;
+    double ns = elapsed_ns([&] {
+        for (size_t i = 0; i < ops; ++i) {
+            size_t pos = Where == 0 ? 0 : Where == 1 ? v.size() / 2 : v.size();
+            v.insert(v.begin() + pos, item);
+            v.erase(v.begin() + pos);
+        }
+    });
+    keep(v);
+    return {ns, ops};
+}
+
+template <class V>
+timing micro_copy(size_t n) {
+    V v = make_filled<V>(n);
+    double ns = elapsed_ns([&] {
+        V copy = v;
+        keep(copy);
+    });
+    return {ns, n};
+}
+
+template <class V>
+timing micro_move(size_t n) {
+    V v = make_filled<V>(n);
+    double ns = elapsed_ns([&] {
+        for (size_t i = 0; i < 1000; ++i) {
+            V moved = std::move(v);
+            v = std::move(moved);
+        }
+    });
+    keep(v);
+    return {ns, 1000};
+}
+
+template <class V>
+timing micro_swap(size_t n) {
+    V a = make_filled<V>(n);
+    V b = make_filled<V>(n / 2);
+    double ns = elapsed_ns([&] {
+        for (size_t i = 0; i < 1000; ++i) {
+            a.swap(b);
+            keep(a);
+        }
+    });
+    return {ns, 1000};
+}
+
+template <class V>
+timing micro_equal(size_t n) {
+    V a = make_filled<V>(n);
+    V b = a;
+    bool equal = false;
+    double ns = elapsed_ns([&] { equal = a == b; });
+    keep(equal);
+    return {ns, n};
+}
+
+struct micro_result {
+    std::string benchmark;
+    const char* type;
+    const char* container;
+    size_t n;
+    double ns_per_item;
+    size_t allocs;
+};
+
+static vector<micro_result> micro_results;
+
+double micro_median(timing (*bench)(size_t), size_t n, size_t repetitions, size_t& allocs) {
+    vector<double> samples;
+    size_t allocations_before = allocations;
+    for (size_t r = 0; r < repetitions; ++r) {
+        timing t = bench(n);
+        samples.push_back(t.ns / t.items);
+    }
+    allocs = (allocations - allocations_before) / repetitions;
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+void micro_compare(const char* name, const char* type, size_t n, timing (*mine)(size_t),
+                   timing (*std_one)(size_t)) {
+    const size_t repetitions = 7;
+    size_t mine_allocs = 0;
+    size_t std_allocs = 0;
+    double mine_ns = micro_median(mine, n, repetitions, mine_allocs);
+    double std_ns = micro_median(std_one, n, repetitions, std_allocs);
+    std::printf("%-20s %-12s %8zu %12.2f %12.2f %8.2fx\n", name, type, n, mine_ns, std_ns,
+                std_ns / mine_ns);
+    micro_results.push_back({name, type, "my_vector", n, mine_ns, mine_allocs});
+    micro_results.push_back({name, type, "std::vector", n, std_ns, std_allocs});
+}
+
+template <class T>
+void micro_suite(const char* type, size_t n) {
+    using mine = my_vector<T>;
+    using std_one = vector<T>;
+    micro_compare("push_back", type, n, micro_push_back<mine>, micro_push_back<std_one>);
+    micro_compare("emplace_back", type, n, micro_emplace_back<mine>, micro_emplace_back<std_one>);
+    micro_compare("reserve+fill", type, n, micro_reserve_fill<mine>, micro_reserve_fill<std_one>);
+    micro_compare("iterate", type, n, micro_iterate<mine>, micro_iterate<std_one>);
+    micro_compare("operator[] random", type, n, micro_random_access<mine>,
+                  micro_random_access<std_one>);
+    micro_compare("insert/erase front", type, n, micro_insert_erase<mine, 0>,
+                  micro_insert_erase<std_one, 0>);
+    micro_compare("insert/erase middle", type, n, micro_insert_erase<mine, 1>,
+                  micro_insert_erase<std_one, 1>);
+    micro_compare("insert/erase back", type, n, micro_insert_erase<mine, 2>,
+                  micro_insert_erase<std_one, 2>);
+    micro_compare("copy", type, n, micro_copy<mine>, micro_copy<std_one>);
+    micro_compare("move", type, n, micro_move<mine>, micro_move<std_one>);
+    micro_compare("swap", type, n, micro_swap<mine>, micro_swap<std_one>);
+    micro_compare("operator==", type, n, micro_equal<mine>, micro_equal<std_one>);
+}
+
+void write_micro_json(const char* path) {
+    std::ofstream out(path);
+    out << "{\n  \"unit\": \"ns_per_item\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < micro_results.size(); ++i) {
+        const micro_result& res = micro_results[i];
+        out << "    {\"name\": \"" << res.benchmark << "\", \"type\": \"" << res.type
+            << "\", \"container\": \"" << res.container << "\", \"n\": " << res.n
+            << ", \"ns_per_item\": " << res.ns_per_item << ", \"allocs\": " << res.allocs << "}"
+            << (i + 1 < micro_results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+// Usage: MyVectorBench [--micro] [--json FILE]. --micro runs only the microbenchmark suite;
+// --json also writes its results to FILE.
+int main(int argc, char** argv) {
+    bool micro_only = false;
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--micro") == 0) {
+            micro_only = true;
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--micro] [--json FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("%-20s %-12s %8s %12s %12s %9s\n", "benchmark", "type", "n", "my_vector",
+                "std::vector", "speedup");
+    micro_suite<int>("int", 1 << 16);
+    micro_suite<std::string>("std::string", 1 << 16);
+    micro_suite<Blob>("Blob<256>", 1 << 12);
+    if (json_path != nullptr) {
+        write_micro_json(json_path);
+    }
+    if (micro_only) {
+        return 0;
+    }
+
+    const size_t n = 1 << 20;
+
+    run("my_vector<std::string>::push_back", [&] { push_back_strings<my_vector<std::string>>(n); });
+    run("std::vector<std::string>::push_back", [&] { push_back_strings<vector<std::string>>(n); });
+
+    run("my_vector<int>::insert/erase middle", [&] { insert_erase_middle<my_vector<int>>(n, 1000); });
+    run("std::vector<int>::insert/erase middle", [&] { insert_erase_middle<vector<int>>(n, 1000); });
+
+    run("my_vector<int> batch ingest, insert one by one",
+        [&] { batch_ingest<my_vector<int>>(20, 10'000, false); });
+    run("my_vector<int> batch ingest, range insert",
+        [&] { batch_ingest<my_vector<int>>(20, 10'000, true); });
+    run("std::vector<int> batch ingest, range insert",
+        [&] { batch_ingest<vector<int>>(20, 10'000, true); });
+
+    arena request_arena;
+    pool request_pool;
+    run("my_vector<int> small vectors, std::allocator",
+        [&] { small_vectors<my_vector<int>>(100, 1000, 20); });
+    run("my_vector<int> small vectors, arena_allocator",
+        [&] { small_vectors<my_vector<int, arena_allocator<int>>>(100, 1000, 20, request_arena); });
+    run("my_vector<int> small vectors, pool_allocator",
+        [&] { small_vectors<my_vector<int, pool_allocator<int>>>(100, 1000, 20, request_pool); });
+
+    run("my_vector<int> small vectors",
+        [&] { small_vectors<my_vector<int>>(100, 1000, 6); });
+    run("small_vector<int, 8> small vectors",
+        [&] { small_vectors<small_vector<int, 8>>(100, 1000, 6); });
+
+    run("my_vector<unsigned> sum/transform loop",
+        [&] { sum_transform<my_vector<unsigned>>(n, 100); });
+    run("std::vector<unsigned> sum/transform loop",
+        [&] { sum_transform<vector<unsigned>>(n, 100); });
+
+    run("my_vector<unsigned> operator[] random access",
+        [&] { random_access<my_vector<unsigned>>(n, 50'000'000); });
+    run("std::vector<unsigned> operator[] random access",
+        [&] { random_access<vector<unsigned>>(n, 50'000'000); });
+
+    const size_t table = size_t(64) << 20;
+    run("my_vector<unsigned> random lookup in 256 MiB, std::allocator",
+        [&] { random_lookup<my_vector<unsigned>>(table, 50'000'000); });
+    run("my_vector<unsigned> random lookup in 256 MiB, huge_page_allocator", [&] {
+        random_lookup<my_vector<unsigned, huge_page_allocator<unsigned>>>(table, 50'000'000);
+    });
+
+    run("my_vector<uint32_t> ==, <, count(), max()",
+        [&] { compare_scan_members<my_vector<uint32_t>>(1000, 1000, 200); });
+    run("my_vector<uint32_t> ==, <, std::count, max_element",
+        [&] { compare_scan<my_vector<uint32_t>>(1000, 1000, 200); });
+    run("std::vector<uint32_t> ==, <, std::count, max_element",
+        [&] { compare_scan<vector<uint32_t>>(1000, 1000, 200); });
+
+    using bytes = my_vector<unsigned char>;
+    run("my_vector<char> refill 64 MiB, resize",
+        [&] { refill_buffer<bytes>(64 << 20, 20, [](bytes& v, size_t n) { v.resize(n); }); });
+    run("my_vector<char> refill 64 MiB, resize_uninitialized", [&] {
+        refill_buffer<bytes>(64 << 20, 20, [](bytes& v, size_t n) { v.resize_uninitialized(n); });
+    });
+    run("my_vector<char> refill 64 MiB, resize_and_overwrite", [&] {
+        refill_buffer<bytes>(64 << 20, 20, [](bytes& v, size_t n) {
+            v.resize_and_overwrite(n, [](unsigned char*, size_t n) { return n; });
+        });
+    });
+    run("std::vector<char> refill 64 MiB, resize", [&] {
+        refill_buffer<vector<unsigned char>>(
+            64 << 20, 20, [](vector<unsigned char>& v, size_t n) { v.resize(n); });
+    });
+
+    {
+        my_vector<Record> aos;
+        RecordColumns soa;
+        fill_records(aos, soa, n * 4);
+        run("my_vector<Record> scan one field",
+            [&] { scan_field(aos, 20, [](const Record& r) { return r.price; }); });
+        run("soa_vector<...> scan one column",
+            [&] { scan_field(soa.column<0>(), 20, [](double price) { return price; }); });
+    }
+
+    const std::string table_path = "my_vector_bench_table";
+    run("mmap_vector<Record> save 4M", [&] { save_records(table_path, n * 4); });
+    run("my_vector<Record> load 4M from file", [&] { stream_load(table_path); });
+    run("mmap_vector<Record> open 4M", [&] { mmap_load(table_path); });
+    std::remove(table_path.c_str());
+
+    run("my_vector<int> 1M snapshot per request, x1000",
+        [&] { snapshots<my_vector<int>>(n, 1000); });
+    run("cow_vector<int> 1M snapshot per request, x1000",
+        [&] { snapshots<cow_vector<int>>(n, 1000); });
+    run("my_vector<int> 1M, 100 edited full copies", [&] { versions<my_vector<int>>(n, 100); });
+    run("persistent_vector<int> 1M, 100 edited versions",
+        [&] { versions<persistent_vector<int>>(n, 100); });
+
+    const std::string stream_path = "my_vector_bench_stream";
+    run("my_vector<int> save/load 64 MiB, element loop",
+        [&] { save_load(stream_path, size_t(16) << 20, false); });
+    run("my_vector<int> save/load 64 MiB, write_vector/read_vector",
+        [&] { save_load(stream_path, size_t(16) << 20, true); });
+    std::remove(stream_path.c_str());
+
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= 2 * cores; threads *= 2) {
+        run("my_vector<int> parallel fill/copy/transform, 64M",
+            [&] { parallel_bulk(size_t(64) << 20, threads); });
+    }
+
+    for (size_t threads = 1; threads <= 2 * cores; threads *= 2) {
+        run("concurrent_vector<int> shared push_back, 16M",
+            [&] { concurrent_append(size_t(16) << 20, threads); });
+        run("my_vector<int> + std::mutex shared push_back, 16M",
+            [&] { locked_append(size_t(16) << 20, threads); });
+    }
+
+    const size_t big = 100'000'000;
+    run("my_vector<int> growth, doubling_growth",
+        [&] { push_back_ints<my_vector<int>>(big); });
+    run("my_vector<int> growth, malloc_size_growth<1.5x>",
+        [&] { push_back_ints<my_vector<int, std::allocator<int>, malloc_size_growth<>>>(big); });
+
+    const size_t huge = size_t(1) << 28;
+    run("my_vector<int> growth to 1 GiB, copy",
+        [&] { grow_huge<my_vector<int>>(huge); });
+    run("my_vector<int> growth to 1 GiB, mremap",
+        [&] { grow_huge<my_vector<int, mmap_allocator<int>>>(huge); });
+
+    return 0;
+}
@@ -1,13 +1,35 @@
 #include <vector>
 #include "Vector.h"
+#include "Arena.h"
+#include "SmallVector.h"
+#include "MmapAllocator.h"
+#include "SoaVector.h"
+#include "ConcurrentVector.h"
+#include "MmapVector.h"
+#include "Serialize.h"
+#include "CowVector.h"
+#include "PersistentVector.h"
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <cstring>
+#include <filesystem>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <memory_resource>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
 
 using std::vector;
 
-template <class T>
-void compare(const my_vector<T>& my, const vector<T>& v) {
+template <class T, class A>
+void compare(const my_vector<T, A>& my, const vector<T>& v) {
     assert(my.empty() == v.empty());
     assert(my.size() == v.size());
     for (int i = 0; i < my.size(); ++i) {
@@ -73,11 +95,21 @@ void test_resize_reserve_assign_shrink() {
     my_a.resize(3);
     a.resize(3);
     compare(my_a, a);
+    assert(my_a.capacity() == 10);
 
+    my_a.shrink_to_fit();
+    assert(my_a.capacity() == 3);
     my_a.reserve(6);
     assert(my_a.capacity() == 6);
+    const int* data = my_a.data();
+    my_a.resize(6);
+    a.resize(6);
+    compare(my_a, a);
+    assert(my_a.data() == data);
     my_a.shrink_to_fit();
-    assert(my_a.capacity() == 3);
+    assert(my_a.capacity() == 6 && my_a.data() == data);
+    my_a.resize(7);
+    assert(my_a.capacity() == 12);
 }
 
 void test_push_pop() {
@@ -254,6 +286,74 @@ void test_lifetime() {
     }
 }
 
+// Counts its construct() calls; resize must not bypass them.
+template <class T>
+struct construct_counting_allocator : std::allocator<T> {
+    template <class U>
+    struct rebind {
+        using other = construct_counting_allocator<U>;
+    };
+
+    template <class... Args>
+    void construct(T* ptr, Args&&... args) {
+        calls++;
+        ::new (static_cast<void*>(ptr)) T(std::forward<Args>(args)...);
+    }
+
+    static inline size_t calls = 0;
+};
+
+void test_uninitialized_resize() {
+    my_vector<int> a = {1, 2, 3};
+    a.resize_uninitialized(1000);
+    assert(a.size() == 1000 && a[0] == 1 && a[2] == 3);
+    std::fill(a.begin() + 3, a.end(), 7);
+    a.resize_uninitialized(4);
+    const int* data = a.data();
+    a.resize_default_init(500);
+    assert(a.data() == data && a[3] == 7);
+
+    a.resize_and_overwrite(2000, [](int* ptr, size_t n) {
+        assert(n == 2000 && ptr[1] == 2);
+        for (size_t i = 500; i < 600; ++i) {
+            ptr[i] = i;
+        }
+        return size_t(600);
+    });
+    assert(a.size() == 600 && a[0] == 1 && a[599] == 599);
+    bool thrown = false;
+    try {
+        a.resize_and_overwrite(10, [](int*, size_t n) { return n + 1; });
+    } catch (std::length_error&) {
+        thrown = true;
+    }
+    assert(thrown && a.size() == 600);
+
+    my_vector<std::string> b(2, "x");
+    b.resize_default_init(4);
+    assert(b[1] == "x" && b[3].empty());
+
+    my_vector<LifeTester> c;
+    c.resize(10);
+    c.resize(4);
+    assert(LifeTester::alive() == 4 && c.capacity() == 10);
+    c.resize_default_init(8);
+    assert(LifeTester::alive() == 8 && c.capacity() == 10);
+    c.clear();
+    assert(LifeTester::alive() == 0);
+
+    struct Point {
+        int x;
+        double y;
+    };
+    my_vector<Point> d(2, Point{1, 2.5});
+    d.resize(100);
+    assert(d[1].x == 1 && d[99].x == 0 && d[99].y == 0);
+    my_vector<int, construct_counting_allocator<int>> e;
+    e.resize(5);
+    assert(construct_counting_allocator<int>::calls == 5 && e[4] == 0);
+}
+
 struct BadAssign {
     BadAssign() {
     }
@@ -279,6 +379,7 @@ private:
 
 void test_insert_erase_safety() {
     my_vector<BadAssign> a = {1, 2, 3, 4, 5, 6, 7};
+    a.reserve(8);
     bool catched = false;
     try {
         a.insert(a.begin(), 0);
@@ -305,6 +406,1673 @@ void test_insert_erase_safety() {
     compare(a, b);
 }
 
+// Copies throw once the budget runs out.
+struct CopyBudget {
+    CopyBudget() {
+        alive++;
+    }
+
+    CopyBudget(const CopyBudget&) {
+        if (budget-- == 0) {
+            throw std::runtime_error("out of copies");
+        }
+        alive++;
+    }
+
+    ~CopyBudget() {
+        alive--;
+    }
+
+    static int budget;
+    static int alive;
+};
+
+int CopyBudget::budget = 1000;
+int CopyBudget::alive = 0;
+
+void test_copy_rollback() {
+    my_vector<CopyBudget> a(5);
+    CopyBudget::budget = 3;
+    bool catched = false;
+    try {
+        my_vector<CopyBudget> b(a);
+    } catch (std::runtime_error&) {
+        catched = true;
+    }
+    assert(catched && CopyBudget::alive == 5);
+
+    CopyBudget::budget = 100;
+    my_vector<CopyBudget> c(2);
+    CopyBudget::budget = 3;
+    catched = false;
+    try {
+        c = a;
+    } catch (std::runtime_error&) {
+        catched = true;
+    }
+    assert(catched && CopyBudget::alive == 7 && c.size() == 2);
+
+    CopyBudget::budget = 100;
+    c = a;
+    assert(CopyBudget::alive == 10 && c.size() == 5 && c.capacity() == 5);
+
+    my_vector<int> d = {1, 2, 3};
+    my_vector<int> e = d;
+    assert(e == d && e.data() != d.data());
+}
+
+struct MoveCounter {
+    MoveCounter() {
+    }
+
+    MoveCounter(const MoveCounter& a) {
+        copies++;
+    }
+
+    MoveCounter(MoveCounter&& a) noexcept {
+        moves++;
+    }
+
+    static int copies;
+    static int moves;
+};
+
+int MoveCounter::copies = 0;
+int MoveCounter::moves = 0;
+
+struct ThrowingMoveCounter {
+    ThrowingMoveCounter() {
+    }
+
+    ThrowingMoveCounter(const ThrowingMoveCounter& a) {
+        copies++;
+    }
+
+    ThrowingMoveCounter(ThrowingMoveCounter&& a) {
+        moves++;
+    }
+
+    static int copies;
+    static int moves;
+};
+
+int ThrowingMoveCounter::copies = 0;
+int ThrowingMoveCounter::moves = 0;
+
+void test_move_on_growth() {
+    my_vector<MoveCounter> a;
+    for (int i = 0; i < 100; ++i) {
+        a.emplace_back();
+    }
+    a.reserve(1000);
+    a.shrink_to_fit();
+    a.resize(200);
+    assert(MoveCounter::copies == 0);
+    assert(MoveCounter::moves > 0);
+
+    my_vector<ThrowingMoveCounter> b;
+    for (int i = 0; i < 100; ++i) {
+        b.emplace_back();
+    }
+    b.reserve(1000);
+    assert(ThrowingMoveCounter::moves == 0);
+    assert(ThrowingMoveCounter::copies > 0);
+
+    my_vector<std::string> c;
+    for (int i = 0; i < 100; ++i) {
+        c.push_back(std::string(50, 'a' + i % 26));
+    }
+    for (int i = 0; i < 10; ++i) {
+        c.push_back(c[0]);
+    }
+    for (int i = 0; i < 100; ++i) {
+        assert(c[i] == std::string(50, 'a' + i % 26));
+    }
+    for (int i = 100; i < 110; ++i) {
+        assert(c[i] == c[0]);
+    }
+}
+
+struct RelocatableBox {
+    RelocatableBox(int value = 0) : value(new int(value)) {
+    }
+
+    RelocatableBox(const RelocatableBox& a) : value(new int(*a.value)) {
+    }
+
+    ~RelocatableBox() {
+        delete value;
+    }
+
+    RelocatableBox& operator=(const RelocatableBox& a) {
+        *value = *a.value;
+        return *this;
+    }
+
+    bool operator==(const RelocatableBox& a) const {
+        return *value == *a.value;
+    }
+
+private:
+    int* value;
+};
+
+template <>
+struct is_trivially_relocatable<RelocatableBox> : std::true_type {};
+
+void test_trivially_relocatable() {
+    static_assert(is_trivially_relocatable<int>::value);
+    static_assert(is_trivially_relocatable<double*>::value);
+    static_assert(!is_trivially_relocatable<BadAssign>::value);
+
+    const int n = 10;
+    int pos[n] = {0, 0, 1, 0, 3, 2, 6, 4, 2, 8};
+
+    my_vector<RelocatableBox> my_a;
+    vector<RelocatableBox> a;
+    for (int i = 0; i < n; ++i) {
+        my_a.insert(my_a.begin() + pos[i], i);
+        a.insert(a.begin() + pos[i], i);
+        compare(my_a, a);
+    }
+    for (int i = 0; i < n; ++i) {
+        my_a.insert(my_a.begin() + pos[i], my_a[n - 1]);
+        a.insert(a.begin() + pos[i], RelocatableBox(a[n - 1]));
+        compare(my_a, a);
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        my_a.erase(my_a.begin() + pos[i]);
+        a.erase(a.begin() + pos[i]);
+        compare(my_a, a);
+    }
+    my_a.reserve(100);
+    my_a.shrink_to_fit();
+    compare(my_a, a);
+}
+
+template <class T, bool Propagate>
+struct tagged_allocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_move_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_swap = std::bool_constant<Propagate>;
+
+    tagged_allocator(int tag, int* live) : tag(tag), live(live) {
+    }
+
+    template <class U>
+    tagged_allocator(const tagged_allocator<U, Propagate>& a) : tag(a.tag), live(a.live) {
+    }
+
+    T* allocate(size_t n) {
+        *live += n;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        *live -= n;
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    bool operator==(const tagged_allocator& a) const {
+        return tag == a.tag;
+    }
+
+    bool operator!=(const tagged_allocator& a) const {
+        return tag != a.tag;
+    }
+
+    int tag;
+    int* live;
+};
+
+template <bool Propagate>
+void test_allocator_propagation() {
+    using alloc = tagged_allocator<int, Propagate>;
+    int live_a = 0;
+    int live_b = 0;
+    {
+        my_vector<int, alloc> my_a({1, 2, 3}, alloc(1, &live_a));
+        my_vector<int, alloc> my_b({4, 5}, alloc(2, &live_b));
+        assert(live_a == 3 && live_b == 2);
+
+        my_b = my_a;
+        compare(my_b, vector<int>{1, 2, 3});
+        assert(my_b.get_allocator().tag == (Propagate ? 1 : 2));
+        assert(live_a + live_b == 6);
+
+        my_vector<int, alloc> my_c(alloc(2, &live_b));
+        my_c = std::move(my_a);
+        compare(my_c, vector<int>{1, 2, 3});
+        assert(my_a.empty());
+        assert(my_c.get_allocator().tag == (Propagate ? 1 : 2));
+
+        my_vector<int, alloc> my_d(std::move(my_c));
+        compare(my_d, vector<int>{1, 2, 3});
+        assert(my_d.get_allocator() == my_c.get_allocator());
+
+        my_vector<int, alloc> my_e({7, 8}, my_d.get_allocator());
+        my_e.swap(my_d);
+        compare(my_e, vector<int>{1, 2, 3});
+    }
+    assert(live_a == 0 && live_b == 0);
+}
+
+void test_stateful_allocator() {
+#if !defined(MY_VECTOR_DEBUG_ITERATORS) && !defined(MY_VECTOR_INSTRUMENT)
+    static_assert(sizeof(my_vector<int>) == 3 * sizeof(size_t));
+#endif
+    test_allocator_propagation<true>();
+    test_allocator_propagation<false>();
+
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                              std::pmr::null_memory_resource());
+    my_vector<int, std::pmr::polymorphic_allocator<int>> my_a(&arena);
+    vector<int> a;
+    for (int i = 0; i < 100; ++i) {
+        my_a.push_back(i);
+        a.push_back(i);
+    }
+    my_a.insert(my_a.begin() + 50, -1);
+    a.insert(a.begin() + 50, -1);
+    compare(my_a, a);
+    assert(my_a.get_allocator().resource() == &arena);
+    assert(reinterpret_cast<char*>(my_a.data()) >= buffer);
+    assert(reinterpret_cast<char*>(my_a.data()) < buffer + sizeof(buffer));
+}
+
+void test_arena_pool() {
+    arena request_arena(1024);
+    {
+        my_vector<int, arena_allocator<int>> my_a(request_arena);
+        my_vector<std::string, arena_allocator<std::string>> my_b(request_arena);
+        vector<int> a;
+        for (int i = 0; i < 100; ++i) {
+            my_a.push_back(i);
+            my_b.push_back(std::to_string(i));
+            a.push_back(i);
+        }
+        compare(my_a, a);
+        assert(my_b[42] == "42");
+        assert(request_arena.used() >= 100 * sizeof(int));
+    }
+    request_arena.release();
+    assert(request_arena.used() == 0 && request_arena.reserved() == 0);
+
+    pool request_pool;
+    for (int round = 0; round < 10; ++round) {
+        my_vector<int, pool_allocator<int>> my_a(request_pool);
+        vector<int> a;
+        for (int i = 0; i < 100; ++i) {
+            my_a.push_back(i);
+            a.push_back(i);
+        }
+        compare(my_a, a);
+    }
+    size_t reserved = request_pool.upstream().reserved();
+    for (int round = 0; round < 10; ++round) {
+        my_vector<int, pool_allocator<int>> my_a(request_pool);
+        for (int i = 0; i < 100; ++i) {
+            my_a.push_back(i);
+        }
+    }
+    assert(request_pool.upstream().reserved() == reserved);
+    assert(request_pool.reused() > 0);
+
+    {
+        my_vector<double, pool_allocator<double>> my_c(request_pool);
+        my_c.resize(1000);
+        assert(reinterpret_cast<uintptr_t>(my_c.data()) % alignof(double) == 0);
+    }
+    request_pool.release();
+}
+
+template <class T, size_t N>
+void compare(const small_vector<T, N>& my, const vector<T>& v) {
+    assert(my.size() == v.size());
+    assert(std::equal(my.begin(), my.end(), v.begin(), v.end()));
+    assert(my.is_inline() == (my.capacity() == N));
+}
+
+template <class T>
+void test_small_vector_of(const T* x) {
+    const int n = 10;
+    int pos[n] = {0, 0, 1, 0, 3, 2, 6, 4, 2, 8};
+
+    small_vector<T, 4> my_a;
+    vector<T> a;
+    for (int i = 0; i < 3; ++i) {
+        my_a.push_back(x[i]);
+        a.push_back(x[i]);
+    }
+    compare(my_a, a);
+    assert(my_a.is_inline());
+
+    small_vector<T, 4> my_b;
+    vector<T> b;
+    for (int i = 0; i < n; ++i) {
+        my_b.insert(my_b.begin() + pos[i], x[i]);
+        b.insert(b.begin() + pos[i], x[i]);
+        compare(my_b, b);
+    }
+    assert(!my_b.is_inline());
+
+    my_a.swap(my_b);
+    compare(my_a, b);
+    compare(my_b, a);
+    my_a.swap(my_b);
+    compare(my_a, a);
+    compare(my_b, b);
+
+    small_vector<T, 4> my_c = my_b;
+    small_vector<T, 4> my_d = std::move(my_c);
+    compare(my_d, b);
+    assert(my_c.empty());
+    my_c = my_a;
+    my_d = std::move(my_c);
+    compare(my_d, a);
+
+    for (int i = n - 1; i >= 0; --i) {
+        auto it = my_b.erase(my_b.begin() + pos[i]);
+        b.erase(b.begin() + pos[i]);
+        compare(my_b, b);
+        assert(it == my_b.begin() + pos[i]);
+    }
+    my_b.emplace_back(x[0]);
+    my_b.shrink_to_fit();
+    assert(my_b.is_inline());
+    my_b.clear();
+    assert(my_b.empty() && my_b.is_inline());
+}
+
+void test_small_vector() {
+    int x[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    std::string s[10];
+    for (int i = 0; i < 10; ++i) {
+        s[i] = std::string(40, 'a' + i);
+    }
+    test_small_vector_of(x);
+    test_small_vector_of(s);
+
+    {
+        small_vector<LifeTester, 4> a;
+        a.resize(3);
+        a.resize(10);
+        assert(LifeTester::alive() == 10);
+        a.erase(a.begin());
+        a.insert(a.begin() + 2, LifeTester());
+        assert(LifeTester::alive() == 10);
+        a.resize(2);
+        a.shrink_to_fit();
+        assert(LifeTester::alive() == 2);
+    }
+    assert(LifeTester::alive() == 0);
+
+    small_vector<int, 4> odd = {1, 2, 3, 4, 5, 6, 7};
+    for (auto it = odd.begin(); it != odd.end();) {
+        it = *it % 2 == 0 ? odd.erase(it) : it + 1;
+    }
+    assert((odd == small_vector<int, 4>{1, 3, 5, 7}));
+
+    int live = 0;
+    tagged_allocator<int, true> alloc(1, &live);
+    {
+        small_vector<int, 8, tagged_allocator<int, true>> a(alloc);
+        for (int i = 0; i < 8; ++i) {
+            a.push_back(i);
+        }
+        assert(live == 0);
+        a.push_back(8);
+        assert(live == 16);
+    }
+    assert(live == 0);
+}
+
+template <class Policy>
+my_vector<size_t> capacities(size_t n) {
+    my_vector<int, std::allocator<int>, Policy> a;
+    my_vector<size_t> res;
+    for (size_t i = 0; i < n; ++i) {
+        a.push_back(i);
+        if (res.empty() || res.back() != a.capacity()) {
+            res.push_back(a.capacity());
+        }
+        assert(a[i] == static_cast<int>(i));
+    }
+    return res;
+}
+
+void test_growth_policy() {
+    compare(capacities<doubling_growth>(100), vector<size_t>{1, 2, 4, 8, 16, 32, 64, 128});
+    compare(capacities<geometric_growth<3, 2>>(30),
+            vector<size_t>{1, 2, 3, 4, 6, 9, 13, 19, 28, 42});
+    compare(capacities<cache_line_growth<>>(100), vector<size_t>{16, 32, 64, 128});
+
+    my_vector<size_t> rounded = capacities<malloc_size_growth<>>(100000);
+    for (size_t i = 1; i < rounded.size(); ++i) {
+        assert(rounded[i] > rounded[i - 1]);
+        assert(rounded[i] <= rounded[i - 1] * 2);
+    }
+
+#ifdef __GLIBC__
+    my_vector<int, std::allocator<int>, malloc_size_growth<>> a;
+    for (int i = 0; i < 100000; ++i) {
+        a.push_back(i);
+        if (a.size() == 1 || a.size() == a.capacity()) {
+            assert(malloc_usable_size(a.data()) - a.capacity() * sizeof(int) <= sizeof(size_t));
+        }
+    }
+#endif
+
+    my_vector<int, std::allocator<int>, geometric_growth<3, 2>> b;
+    b.reserve(10);
+    assert(b.capacity() == 10);
+}
+
+void test_mmap_allocator() {
+    my_vector<int, mmap_allocator<int, 4096>> my_a;
+    vector<int> a;
+    for (int i = 0; i < 100000; ++i) {
+        my_a.push_back(i);
+        a.push_back(i);
+    }
+    compare(my_a, a);
+    my_a.insert(my_a.begin() + 10, my_a[5]);
+    a.insert(a.begin() + 10, a[5]);
+    my_a.erase(my_a.begin());
+    a.erase(a.begin());
+    compare(my_a, a);
+
+    my_a.resize(100);
+    a.resize(100);
+    my_a.shrink_to_fit();
+    compare(my_a, a);
+    my_a.resize(50000);
+    a.resize(50000);
+    compare(my_a, a);
+    my_a.reserve(200000);
+    compare(my_a, a);
+
+    my_vector<RelocatableBox, mmap_allocator<RelocatableBox, 4096>> my_b;
+    vector<RelocatableBox> b;
+    for (int i = 0; i < 10000; ++i) {
+        my_b.emplace_back(i);
+        b.emplace_back(i);
+    }
+    my_b.insert(my_b.begin() + 3, my_b[9999]);
+    b.insert(b.begin() + 3, RelocatableBox(b[9999]));
+    compare(my_b, b);
+}
+
+void test_huge_page_allocator() {
+    huge_page_counters& stats = huge_page_stats();
+    size_t mapped = stats.mapped_bytes;
+    size_t heap = stats.heap_bytes;
+    {
+        my_vector<int, huge_page_allocator<int, 64, 1 << 16>> a;
+        vector<int> b;
+        for (int i = 0; i < 100000; ++i) {
+            a.push_back(i);
+            b.push_back(i);
+            assert(reinterpret_cast<uintptr_t>(a.data()) % 64 == 0);
+        }
+        compare(a, b);
+        assert(reinterpret_cast<uintptr_t>(a.data()) % (2 << 20) == 0);
+        assert(stats.mapped_bytes == mapped + (2 << 20));
+
+        huge_page_options options{numa_mode::interleave, 1};
+        my_vector<double, huge_page_allocator<double, 4096, 1 << 16>> c(
+            100000, 0.5, huge_page_allocator<double, 4096, 1 << 16>(options));
+        assert(c.get_allocator().options() == options && c.count(0.5) == 100000);
+        my_vector<double, huge_page_allocator<double, 4096, 1 << 16>> d = c;
+        d.resize(10);
+        d.shrink_to_fit();
+        assert(d.get_allocator().options() == options);
+        assert(reinterpret_cast<uintptr_t>(d.data()) % 4096 == 0);
+    }
+    assert(stats.mapped_bytes == mapped && stats.heap_bytes == heap);
+}
+
+template <class F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+struct Row {
+    long long id;
+    double value;
+};
+
+void test_mmap_vector() {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("my_vector_mmap_test_" + std::to_string(getpid()))).string();
+    std::filesystem::remove(path);
+    {
+        mmap_vector<Row> a(path);
+        assert(a.empty() && !a.read_only());
+        for (int i = 0; i < 10000; ++i) {
+            a.push_back({i, i * 0.5});
+        }
+        a.emplace_back(Row{-1, -1});
+        a.pop_back();
+        assert(a.size() == 10000 && a.capacity() >= 10000 && a.back().id == 9999);
+        assert(reinterpret_cast<uintptr_t>(a.data()) % 64 == 0);
+        a.flush();
+    }
+    {
+        mmap_vector<Row> a(path);
+        assert(a.size() == 10000);
+        for (int i = 0; i < 10000; ++i) {
+            assert(a[i].id == i && a[i].value == i * 0.5);
+        }
+        a.resize(10005);
+        assert(a[10004].id == 0 && a.at(10002).value == 0);
+        a.resize(5000);
+        a.shrink_to_fit();
+        assert(a.capacity() == 5000);
+        assert(std::filesystem::file_size(path) == sizeof(mmap_vector_header) + 5000 * sizeof(Row));
+        a.reserve(6000);
+        mmap_vector<Row> b = std::move(a);
+        assert(b.size() == 5000 && b.capacity() == 6000);
+    }
+    {
+        const mmap_vector<Row> a(path, mmap_mode::read_only);
+        assert(a.read_only() && a.size() == 5000 && a.capacity() == 6000);
+        long long sum = 0;
+        for (const Row& row : a) {
+            sum += row.id;
+        }
+        assert(sum == 4999LL * 5000 / 2);
+        mmap_vector<Row> b(path, mmap_mode::read_only);
+        assert(throws([&] { b.push_back({1, 1}); }) && throws([&] { b.clear(); }));
+        assert(throws([&] { b.at(5000); }));
+        assert(throws([&] { b[0].id = 1; }) && throws([&] { b.data()[1].id = 1; }));
+        assert(throws([&] { b.begin(); }) && std::as_const(b)[0].id == 0);
+    }
+    assert(throws([&] { mmap_vector<int> wrong(path); }));
+    std::filesystem::remove(path);
+    assert(throws([&] { mmap_vector<Row> missing(path, mmap_mode::read_only); }));
+}
+
+void test_serialization() {
+    my_vector<int> a(100000);
+    std::iota(a.begin(), a.end(), 0);
+    std::stringstream stream;
+    write_vector(stream, a);
+    my_vector<int> b = {1, 2, 3};
+    read_vector(stream, b);
+    assert(a == b);
+
+    my_vector<Row> rows;
+    for (int i = 0; i < 1000; ++i) {
+        rows.push_back({i, i * 0.25});
+    }
+    my_vector<std::string> strings = {"", "one", std::string(1000, 'x')};
+    std::stringstream mixed;
+    write_vector(mixed, rows);
+    write_vector(mixed, strings);
+    vector_reader<Row> reader(mixed, 100 * sizeof(Row));
+    my_vector<Row> rows_back;
+    assert(reader.size() == 1000 && reader.read_some(rows_back, 300) == 300);
+    assert(reader.remaining() == 700 && rows_back.back().id == 299);
+    reader.read_all(rows_back);
+    assert(reader.remaining() == 0 && rows_back.size() == 1000 && rows_back[999].value == 249.75);
+    my_vector<std::string> strings_back;
+    read_vector(mixed, strings_back);
+    assert(strings_back == strings);
+
+    // Long strings are read in several chunks; a corrupted length runs out of input instead of
+    // allocating it.
+    my_vector<std::string> long_strings = {std::string(200000, 'y'), "z"};
+    std::stringstream long_stream;
+    write_vector(long_stream, long_strings);
+    std::string long_bytes = long_stream.str();
+    read_vector(long_stream, strings_back);
+    assert(strings_back == long_strings);
+    uint64_t huge = uint64_t(1) << 60;
+    std::memcpy(long_bytes.data() + sizeof(vector_stream_header), &huge, sizeof(huge));
+    std::stringstream corrupted(long_bytes);
+    bool truncated_string = false;
+    try {
+        read_vector(corrupted, strings_back);
+    } catch (std::runtime_error&) {
+        truncated_string = true;
+    }
+    assert(truncated_string && strings_back.empty());
+
+    std::string bytes = stream.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    assert(throws([&] { read_vector(truncated, b); }) && b.empty());
+    std::stringstream wrong_type(bytes);
+    assert(throws([&] { read_vector(wrong_type, rows_back); }));
+    std::stringstream not_a_vector("definitely not a vector header");
+    assert(throws([&] { read_vector(not_a_vector, b); }));
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    my_vector<int> small(1000, 7);
+    write_vector(fds[1], small);
+    close(fds[1]);
+    my_vector<int> small_back;
+    vector_reader<int>(fds[0], 256).read_all(small_back);
+    close(fds[0]);
+    assert(small_back == small);
+
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("my_vector_serialize_test_" + std::to_string(getpid()))).string();
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    write_vector(fd, a);
+    lseek(fd, 0, SEEK_SET);
+    read_vector(fd, b);
+    close(fd);
+    std::filesystem::remove(path);
+    assert(a == b && b.capacity() == a.size());
+}
+
+// Counts the bytes it hands out, so a block freed through the wrong resource unbalances both.
+struct counting_resource : std::pmr::memory_resource {
+    void* do_allocate(size_t bytes, size_t align) override {
+        live += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t align) override {
+        live -= bytes;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& anoth) const noexcept override {
+        return this == &anoth;
+    }
+
+    long live = 0;
+};
+
+void test_cow_vector_allocators() {
+    using pmr_cow = cow_vector<int, std::pmr::polymorphic_allocator<int>>;
+    counting_resource first;
+    counting_resource second;
+    {
+        pmr_cow a({1, 2, 3}, &first);
+        pmr_cow b({4, 5}, &second);
+        b = a;
+        a.clear();
+        b.clear();
+        assert(first.live == 0 && second.live == 0);
+
+        pmr_cow c({6}, &first);
+        b = std::move(c);
+        b.push_back(7);
+        b.clear();
+        assert(first.live == 0 && second.live == 0);
+
+        a = pmr_cow({8}, &first);
+        b = a;
+        b.push_back(9);
+        assert(first.live > 0 && second.live > 0 && a.use_count() == 1);
+        a.clear();
+        assert(first.live == 0 && second.live > 0);
+        pmr_cow d({10}, &first);
+        d[0] = 11;
+        b = d;
+        assert(b.use_count() == 1 && b[0] == 11);
+    }
+    assert(first.live == 0 && second.live == 0);
+
+    // Copies select their allocator like my_vector; polymorphic_allocator picks the default
+    // resource and does not propagate on swap.
+    {
+        pmr_cow a({1, 2}, &first);
+        pmr_cow b = a;
+        assert(b.get_allocator().resource() == std::pmr::get_default_resource());
+        assert(b.use_count() == 2);
+        a[0] = 5;
+        long first_live = first.live;
+        pmr_cow c = a;
+        assert(c.use_count() == 1 && c[0] == 5 && first.live == first_live);
+        pmr_cow d({3}, &second);
+        d.swap(a);
+        assert(a.get_allocator().resource() == &first && d.get_allocator().resource() == &second);
+        assert(a[0] == 3 && d[0] == 5);
+    }
+    assert(first.live == 0 && second.live == 0);
+
+    // Allocators without a default constructor work while the vector has no buffer.
+    arena cow_arena(1024);
+    cow_vector<int, arena_allocator<int>> empty{arena_allocator<int>(cow_arena)};
+    assert(empty.size() == 0 && empty.capacity() == 0 && empty.begin() == empty.end());
+    assert(empty.data() == nullptr && empty.view().empty() && throws([&] { empty.at(0); }));
+    cow_vector<int, arena_allocator<int>> filled = empty;
+    filled.push_back(1);
+    assert(filled != empty && filled.size() == 1 && empty.size() == 0);
+    auto after = filled.erase(filled.cbegin());
+    assert(after == filled.cend() && filled == empty);
+    empty.clear();
+    assert(empty.erase(empty.cbegin(), empty.cend()) == empty.cend());
+}
+
+void test_cow_vector() {
+    cow_vector<std::string> a = {"a", "b", "c"};
+    cow_vector<std::string> b = a;
+    const cow_vector<std::string>& view = b;
+    assert(a.use_count() == 2 && view.data() == std::as_const(a).data() && a == b);
+
+    b.push_back(b.back());
+    assert(a.use_count() == 1 && b.use_count() == 1);
+    assert(a.size() == 3 && b.size() == 4 && view[3] == "c");
+
+    cow_vector<std::string> c = b;
+    auto it = c.insert(c.cbegin() + 1, view[0]);
+    assert(*it == "a" && c.size() == 5 && b.size() == 4 && view[1] == "b");
+    it = c.erase(c.cbegin(), c.cbegin() + 2);
+    assert(*it == "b" && c.size() == 3 && b.size() == 4);
+
+    cow_vector<std::string> d = a;
+    d[0] = "changed";
+    assert(a[0] == "a" && d[0] == "changed");
+    // d has handed out a mutable reference, so its copies are deep.
+    cow_vector<std::string> e = d;
+    assert(e.use_count() == 1 && d.use_count() == 1);
+
+    cow_vector<std::string> f = a;
+    f.clear();
+    assert(f.empty() && f.use_count() == 0 && a.size() == 3);
+    f.emplace_back(3, 'x');
+    assert(f[0] == "xxx" && throws([&] { std::as_const(f).at(1); }));
+
+    my_vector<int> items(1000, 5);
+    const int* buffer = items.data();
+    cow_vector<int> g(std::move(items));
+    assert(std::as_const(g).data() == buffer && g.size() == 1000);
+
+    cow_vector<int> shared(100000, 1);
+    my_vector<std::thread> readers;
+    std::atomic<bool> ok = true;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&shared, &ok] {
+            for (int i = 0; i < 50; ++i) {
+                const cow_vector<int> snapshot = shared;
+                ok = ok && std::ranges::count(snapshot.view(), 1) == 100000;
+            }
+        });
+    }
+    cow_vector<int> writer = shared;
+    for (int i = 0; i < 100; ++i) {
+        writer.push_back(2);
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    assert(ok && writer.size() == 100100 && shared.size() == 100000);
+}
+
+void test_persistent_vector() {
+    persistent_vector<int> empty;
+    persistent_vector<int> a = empty.push_back(1).push_back(2);
+    assert(empty.empty() && a.size() == 2 && a[1] == 2);
+    assert(throws([&] { return empty.pop_back(); }) && throws([&] { return a.at(2); }));
+
+    // Versions built one step at a time; every 97th is checked against a flat copy.
+    std::vector<persistent_vector<int>> versions = {empty};
+    std::vector<int> flat;
+    std::vector<std::pair<size_t, std::vector<int>>> checks;
+    auto record = [&](persistent_vector<int> next) {
+        versions.push_back(std::move(next));
+        if (versions.size() % 97 == 0) {
+            checks.emplace_back(versions.size() - 1, flat);
+        }
+    };
+    for (int i = 0; i < 40000; ++i) {
+        flat.push_back(i);
+        record(versions.back().push_back(i));
+        if (i % 997 == 0) {
+            flat[i / 2] = -i;
+            record(versions.back().set(i / 2, -i));
+        }
+        if (i % 1231 == 1230) {
+            for (int k = 0; k < 40; ++k) {
+                flat.pop_back();
+                record(versions.back().pop_back());
+            }
+        }
+    }
+    for (const auto& [v, items] : checks) {
+        assert(std::equal(versions[v].begin(), versions[v].end(), items.begin(), items.end()));
+    }
+    const persistent_vector<int>& last = versions.back();
+    my_vector<int> copy = last.to_vector();
+    assert(std::equal(copy.begin(), copy.end(), flat.begin(), flat.end()));
+
+    for (size_t first : {size_t(0), size_t(31), size_t(33), size_t(1025), flat.size() / 2}) {
+        for (size_t count : {size_t(0), size_t(1), size_t(32), size_t(100), size_t(5000)}) {
+            size_t end = std::min(first + count, flat.size());
+            persistent_vector<int> part = last.slice(first, end);
+            assert(std::equal(part.begin(), part.end(), flat.begin() + first, flat.begin() + end));
+            persistent_vector<int> grown = part.push_back(7).push_back(7).set(0, 8);
+            assert(grown.size() == end - first + 2 && grown[0] == 8 && grown.back() == 7);
+            assert(part.empty() || part[0] == flat[first]);
+        }
+    }
+    assert(last.slice(0, last.size()) == last && last.drop(last.size()).empty());
+    assert(throws([&] { return last.slice(2, 1); }));
+
+    persistent_vector<std::string> words = {"a", "b", "c"};
+    transient_vector<std::string> batch = words.transient();
+    for (int i = 0; i < 1000; ++i) {
+        batch.push_back(std::to_string(i));
+    }
+    batch.set(0, "z");
+    batch.pop_back();
+    batch.drop(1);
+    persistent_vector<std::string> more = batch.persistent();
+    assert(batch.empty() && words.size() == 3 && words[0] == "a");
+    assert(more.size() == 1001 && more[0] == "b" && more.back() == "998");
+    assert(more.to_vector().size() == 1001);
+
+    // A copy failing halfway through the range constructor frees the nodes built so far.
+    CopyBudget::budget = 1000;
+    my_vector<CopyBudget> budgeted(100);
+    CopyBudget::budget = 70;
+    bool catched = false;
+    try {
+        persistent_vector<CopyBudget> partial(budgeted.begin(), budgeted.end());
+    } catch (std::runtime_error&) {
+        catched = true;
+    }
+    assert(catched && CopyBudget::alive == 100);
+
+    persistent_vector<int> shared(copy);
+    std::atomic<bool> ok = true;
+    my_vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&shared, &ok, t] {
+            persistent_vector<int> mine = shared;
+            for (int i = 0; i < 1000; ++i) {
+                mine = mine.set(i, t).push_back(t);
+            }
+            ok = ok && mine[999] == t && mine.back() == t && shared[0] == 0;
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    assert(ok && shared == persistent_vector<int>(copy));
+}
+
+void test_iterator_checks() {
+#ifdef MY_VECTOR_DEBUG_ITERATORS
+    my_vector<int> a = {1, 2, 3};
+    auto it = a.begin() + 1;
+    assert(*it == 2);
+    assert(throws([&] { return a.end() + 1; }));
+    a.push_back(4);
+    assert(throws([&] { return *it; }));
+    assert(throws([&] { a.insert(it, 5); }));
+
+    my_vector<int> b = {1, 2, 3};
+    assert(throws([&] { a.erase(b.begin()); }));
+    it = a.begin();
+    a.erase(a.begin() + 3);
+    assert(*it == 1);
+    a.clear();
+    assert(throws([&] { return *it; }));
+#else
+    static_assert(std::is_same_v<my_vector<int>::iterator, int*>);
+    static_assert(std::is_same_v<my_vector<int>::const_iterator, const int*>);
+#endif
+}
+
+void test_iterator_conformance() {
+    static_assert(std::contiguous_iterator<my_vector<int>::iterator>);
+    static_assert(std::contiguous_iterator<my_vector<int>::const_iterator>);
+    static_assert(std::ranges::contiguous_range<my_vector<int>>);
+    static_assert(std::ranges::contiguous_range<const my_vector<int>>);
+    static_assert(std::is_convertible_v<my_vector<int>::iterator, my_vector<int>::const_iterator>);
+    static_assert(!std::is_convertible_v<my_vector<int>::const_iterator, my_vector<int>::iterator>);
+
+    my_vector<int> my_a = {5, 3, 9, 1, 7, 2, 8};
+    vector<int> a = {5, 3, 9, 1, 7, 2, 8};
+    std::sort(my_a.begin(), my_a.end());
+    std::sort(a.begin(), a.end());
+    compare(my_a, a);
+    assert(std::lower_bound(my_a.cbegin(), my_a.cend(), 7) - my_a.cbegin() == 4);
+    assert(std::ranges::binary_search(my_a, 8));
+
+    auto it = my_a.begin();
+    it += 3;
+    assert(it[1] == 7 && *(it - 1) == 3 && *(2 + it) == 8);
+    it -= 2;
+    my_vector<int>::const_iterator const_it = it;
+    assert(const_it == my_a.cbegin() + 1 && my_a.cend() - const_it == 6);
+    assert(const_it < my_a.cend() && my_a.cbegin() <= const_it);
+
+    vector<int> reversed(my_a.rbegin(), my_a.rend());
+    assert(std::equal(reversed.begin(), reversed.end(), a.rbegin(), a.rend()));
+    const my_vector<int>& const_a = my_a;
+    assert(*const_a.rbegin() == 9 && *(const_a.crend() - 1) == 1);
+
+    std::span<int> span(my_a);
+    assert(span.size() == my_a.size() && span.data() == my_a.data());
+    span[0] = 42;
+    assert(my_a[0] == 42);
+
+    my_a.insert(my_a.cbegin() + 1, 10);
+    my_a.erase(my_a.cend() - 1);
+    my_a.emplace(my_a.cend(), 11);
+    a[0] = 42;
+    a.insert(a.cbegin() + 1, 10);
+    a.erase(a.cend() - 1);
+    a.emplace(a.cend(), 11);
+    compare(my_a, a);
+}
+
+// Refuses buffers of more than 1000 elements.
+template <class T>
+struct limited_allocator : std::allocator<T> {
+    template <class U>
+    struct rebind {
+        using other = limited_allocator<U>;
+    };
+
+    T* allocate(size_t n) {
+        if (n > 1000) {
+            throw std::bad_alloc();
+        }
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+// Fails with its own exception type instead of std::bad_alloc.
+template <class T>
+struct failing_allocator : std::allocator<T> {
+    template <class U>
+    struct rebind {
+        using other = failing_allocator<U>;
+    };
+
+    T* allocate(size_t n) {
+        if (n > 1000) {
+            throw std::runtime_error("failing_allocator");
+        }
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+size_t handled_errors = 0;
+
+void count_error(vector_status, const char*) {
+    handled_errors++;
+}
+
+void test_error_handling() {
+    my_vector<int> a = {1, 2, 3};
+    static_assert(noexcept(a.size()) && noexcept(a.data()) && noexcept(a.begin()));
+#ifndef MY_VECTOR_BOUNDS_CHECK
+    static_assert(noexcept(a[0]) && noexcept(a.back()));
+#endif
+    // With exceptions the allocator, the handler or a hook may throw, even from the try_
+    // functions.
+    static_assert(!noexcept(a.push_back(1)) && !noexcept(a.reserve(1)));
+    static_assert(!noexcept(a.try_push_back(1)) && !noexcept(a.try_reserve(1)));
+
+    assert(a.try_reserve(100) == vector_status::ok && a.capacity() == 100);
+    size_t huge = std::numeric_limits<size_t>::max() / 2;
+    assert(a.try_reserve(huge) == vector_status::length_error && a.capacity() == 100);
+    my_vector<int, limited_allocator<int>> limited(10, 1);
+    assert(limited.try_reserve(1001) == vector_status::out_of_memory && limited.capacity() == 10);
+    assert(throws([&] { limited.resize(2000); }) && limited.size() == 10);
+
+    a.shrink_to_fit();
+    assert(a.try_push_back(a[0]) == vector_status::ok && a.back() == 1 && a.size() == 4);
+    my_vector<std::string> b;
+    for (int i = 0; i < 100; ++i) {
+        assert(b.try_emplace_back(3, 'x') == vector_status::ok);
+    }
+    assert(b.size() == 100 && b[99] == "xxx");
+
+    // Only std::bad_alloc becomes a status; other allocator exceptions propagate.
+    my_vector<int, failing_allocator<int>> failing(10, 1);
+    bool catched = false;
+    try {
+        (void)failing.try_reserve(1001);
+    } catch (std::runtime_error&) {
+        catched = true;
+    }
+    assert(catched && failing.capacity() == 10 && failing.size() == 10);
+
+    // The handler sees each failure before the exception.
+    vector_error_handler old = set_vector_error_handler(count_error);
+    assert(throws([&] { a.at(10); }) && handled_errors == 1);
+    assert(throws([&] { a.reserve(huge); }) && handled_errors == 2);
+    my_vector<int> empty;
+    assert(throws([&] { empty.pop_back(); }) && handled_errors == 3);
+    assert(a.try_reserve(huge) == vector_status::length_error && handled_errors == 3);
+    assert(set_vector_error_handler(old) == count_error);
+}
+
+void test_element_access() {
+    my_vector<std::string> a = {"a", "b", "c"};
+    const my_vector<std::string>& const_a = a;
+    static_assert(std::is_same_v<decltype(const_a[0]), const std::string&>);
+    static_assert(std::is_same_v<decltype(const_a.front()), const std::string&>);
+    assert(&const_a[1] == a.data() + 1);
+    assert(&const_a.back() == a.data() + 2);
+    assert(a.at(2) == "c" && const_a.at(0) == "a");
+
+    bool catched = false;
+    try {
+        a.at(3);
+    } catch (std::out_of_range&) {
+        catched = true;
+    }
+    assert(catched);
+
+    small_vector<int, 2> b = {1, 2, 3};
+    assert(b.at(2) == 3 && throws([&] { return b.at(3); }));
+
+#ifdef MY_VECTOR_BOUNDS_CHECK
+    assert(throws([&] { return a[3]; }));
+    assert(throws([&] { return b[3]; }));
+    a.clear();
+    assert(throws([&] { return a.front(); }));
+    assert(throws([&] { return const_a.back(); }));
+#endif
+}
+
+struct OpCounter {
+    OpCounter(int value = 0) : value(value) {
+        defaults += value == 0;
+    }
+
+    OpCounter(int a, int b) : value(a + b) {
+    }
+
+    OpCounter(const OpCounter& a) : value(a.value) {
+        copies++;
+    }
+
+    OpCounter(OpCounter&& a) noexcept : value(a.value) {
+        moves++;
+    }
+
+    OpCounter& operator=(const OpCounter& a) {
+        value = a.value;
+        copies++;
+        return *this;
+    }
+
+    OpCounter& operator=(OpCounter&& a) noexcept {
+        value = a.value;
+        moves++;
+        return *this;
+    }
+
+    bool operator==(const OpCounter& a) const {
+        return value == a.value;
+    }
+
+    static void reset() {
+        defaults = copies = moves = 0;
+    }
+
+    int value;
+    static int defaults;
+    static int copies;
+    static int moves;
+};
+
+int OpCounter::defaults = 0;
+int OpCounter::copies = 0;
+int OpCounter::moves = 0;
+
+template <class V>
+void test_forwarding_of() {
+    V a;
+    a.reserve(8);
+    OpCounter::reset();
+    OpCounter x(5);
+    a.push_back(x);
+    a.push_back(OpCounter(6));
+    OpCounter& ref = a.emplace_back(3, 4);
+    assert(&ref == &a.back() && ref.value == 7);
+    assert(OpCounter::copies == 1 && OpCounter::moves == 1);
+
+    OpCounter::reset();
+    a.emplace(a.end(), 1, 1);
+    assert(OpCounter::copies == 0 && OpCounter::moves == 0);
+    auto it = a.insert(a.begin() + 1, OpCounter(8));
+    assert(it == a.begin() + 1 && it->value == 8);
+    a.emplace(a.begin(), 2, 2);
+    assert(OpCounter::defaults == 0 && OpCounter::copies == 0);
+
+    a.shrink_to_fit();
+    OpCounter::reset();
+    it = a.emplace(a.begin() + 2, 10, 10);
+    assert(it->value == 20);
+    assert(OpCounter::defaults == 0 && OpCounter::copies == 0);
+    a.insert(a.begin(), a[3]);
+    assert(OpCounter::defaults == 0 && OpCounter::copies == 1);
+
+    vector<OpCounter> b = {{4}, {5}, {20}, {8}, {6}, {7}, {2}};
+    b.insert(b.begin(), b[3]);
+    assert(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+}
+
+void test_forwarding() {
+    test_forwarding_of<my_vector<OpCounter>>();
+    test_forwarding_of<small_vector<OpCounter, 2>>();
+
+    my_vector<std::string> a;
+    std::string s(100, 'x');
+    const char* buffer = s.data();
+    a.push_back(std::move(s));
+    assert(a[0].data() == buffer);
+}
+
+template <class T>
+T make_value(int value) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        return std::to_string(value);
+    } else {
+        return T(value);
+    }
+}
+
+template <class T>
+void test_bulk_operations_of() {
+    vector<T> src;
+    for (int i = 0; i < 20; ++i) {
+        src.push_back(make_value<T>(i * 3 + 10));
+    }
+    my_vector<T> a(src.begin(), src.begin() + 5);
+    vector<T> b(src.begin(), src.begin() + 5);
+    assert(a.capacity() == 5);
+    compare(a, b);
+
+    auto it = a.insert(a.begin() + 2, src.begin() + 5, src.begin() + 8);
+    b.insert(b.begin() + 2, src.begin() + 5, src.begin() + 8);
+    assert(it == a.begin() + 2);
+    compare(a, b);
+
+    a.reserve(40);
+    b.reserve(40);
+    a.insert(a.begin() + 1, src.begin() + 8, src.end());
+    b.insert(b.begin() + 1, src.begin() + 8, src.end());
+    compare(a, b);
+    a.insert(a.end() - 1, src.begin(), src.begin() + 2);
+    b.insert(b.end() - 1, src.begin(), src.begin() + 2);
+    compare(a, b);
+
+    a.insert(a.begin() + 3, 4, a[0]);
+    b.insert(b.begin() + 3, 4, b[0]);
+    compare(a, b);
+    a.append_range(std::span(src).first(3));
+    b.insert(b.end(), src.begin(), src.begin() + 3);
+    compare(a, b);
+
+    it = a.erase(a.begin() + 2, a.begin() + 9);
+    b.erase(b.begin() + 2, b.begin() + 9);
+    assert(it == a.begin() + 2);
+    compare(a, b);
+    a.erase(a.begin(), a.begin());
+    compare(a, b);
+
+    auto pred = [](const T& x) { return x == make_value<T>(13) || x == make_value<T>(16); };
+    assert(erase_if(a, pred) == std::erase_if(b, pred));
+    compare(a, b);
+    assert(erase(a, make_value<T>(10)) == std::erase(b, make_value<T>(10)));
+    compare(a, b);
+    a.erase(a.begin(), a.end());
+    assert(a.empty());
+}
+
+struct CopyBomb {
+    CopyBomb(int value = 0) : value(value) {
+    }
+
+    CopyBomb(const CopyBomb& a) : value(a.value) {
+        if (--countdown == 0) {
+            throw std::runtime_error("Boom");
+        }
+    }
+
+    CopyBomb(CopyBomb&& a) noexcept : value(a.value) {
+    }
+
+    CopyBomb& operator=(const CopyBomb& a) = default;
+    CopyBomb& operator=(CopyBomb&& a) noexcept = default;
+
+    bool operator==(const CopyBomb& a) const {
+        return value == a.value;
+    }
+
+    int value;
+    static int countdown;
+};
+
+int CopyBomb::countdown = 0;
+
+void test_bulk_operations() {
+    test_bulk_operations_of<int>();
+    test_bulk_operations_of<std::string>();
+    test_bulk_operations_of<RelocatableBox>();
+    test_bulk_operations_of<BadAssign>();
+
+    std::istringstream in("1 2 3 4");
+    my_vector<int> a = {10, 20, 30};
+    a.insert(a.begin() + 1, std::istream_iterator<int>(in), std::istream_iterator<int>());
+    compare(a, {10, 1, 2, 3, 4, 20, 30});
+    std::istringstream more("5 6");
+    a.append_range(std::views::istream<int>(more));
+    compare(a, {10, 1, 2, 3, 4, 20, 30, 5, 6});
+    my_vector<int> c{std::istream_iterator<int>(in), std::istream_iterator<int>()};
+    assert(c.empty());
+
+    vector<CopyBomb> src = {1, 2, 3, 4, 5};
+    for (size_t capacity : {5, 16}) {
+        my_vector<CopyBomb> b = {7, 8, 9, 10, 11};
+        b.reserve(capacity);
+        CopyBomb::countdown = 4;
+        bool catched = false;
+        try {
+            b.insert(b.begin() + 2, src.begin(), src.end());
+        } catch (std::runtime_error&) {
+            catched = true;
+        }
+        assert(catched);
+        compare(b, {7, 8, 9, 10, 11});
+        assert(b.capacity() == capacity);
+    }
+    CopyBomb::countdown = 0;
+}
+
+template <class T>
+void test_simd_operations_of() {
+    for (size_t n : {0, 1, 7, 31, 64, 255, 256, 257, 600}) {
+        vector<T> v(n);
+        for (size_t i = 0; i < n; ++i) {
+            v[i] = static_cast<T>((i * 37 + 11) % 101);
+        }
+        my_vector<T> a(v.begin(), v.end());
+        my_vector<T> b = a;
+        assert(a == b && !(a != b) && (a <=> b) == 0);
+        assert(a.count(T(11)) == static_cast<size_t>(std::count(v.begin(), v.end(), T(11))));
+        assert(a.contains(T(11)) == (n > 0));
+        assert(!a.contains(T(102)));
+        if (n > 0) {
+            assert(a.min() == *std::min_element(v.begin(), v.end()));
+            assert(a.max() == *std::max_element(v.begin(), v.end()));
+        }
+        for (size_t pos : {size_t(0), n / 2, n - 1}) {
+            if (pos >= n) {
+                continue;
+            }
+            b[pos] = T(120);
+            vector<T> w(b.begin(), b.end());
+            assert(a != b && !(a == b));
+            assert((a <=> b) == (v <=> w) && a < b && b > a);
+            assert(b.find(T(120)) == b.begin() + pos);
+            assert(b.max() == T(120));
+            b[pos] = a[pos];
+        }
+        b.push_back(T(0));
+        assert(a < b && a != b);
+        my_vector<T> filled(n, T(5));
+        assert(filled.count(T(5)) == n);
+        filled.assign(n + 3, T(9));
+        assert(filled.count(T(9)) == n + 3 && filled.find(T(5)) == filled.end());
+    }
+}
+
+struct LessOnly {
+    int value;
+
+    bool operator<(const LessOnly& a) const {
+        return value < a.value;
+    }
+};
+
+void test_simd_operations() {
+    test_simd_operations_of<uint8_t>();
+    test_simd_operations_of<int16_t>();
+    test_simd_operations_of<uint32_t>();
+    test_simd_operations_of<int64_t>();
+    test_simd_operations_of<float>();
+    test_simd_operations_of<double>();
+
+    my_vector<double> a(300, 1.0);
+    my_vector<double> b = a;
+    a[250] = NAN;
+    b[250] = NAN;
+    assert(a != b && (a <=> b) == std::partial_ordering::unordered);
+    assert(a.min() == 1.0 && a.max() == 1.0);
+    assert(!a.contains(NAN) && a.count(1.0) == 299);
+    a[0] = NAN;
+    assert(std::isnan(a.min()));
+    b[250] = -0.0;
+    a = b;
+    a[250] = 0.0;
+    assert(a == b);
+
+    // Equal extrema in different lanes: the first one wins, as in std::min_element.
+    for (size_t first : {size_t(1), size_t(5), size_t(70)}) {
+        my_vector<double> zeros(300, 1.0);
+        zeros[first] = 0.0;
+        zeros[first + 3] = -0.0;
+        zeros[200] = -0.0;
+        assert(!std::signbit(zeros.min()));
+        zeros[first] = -0.0;
+        zeros[first + 3] = 0.0;
+        assert(std::signbit(zeros.min()));
+        std::transform(zeros.begin(), zeros.end(), zeros.begin(), [](double x) { return -x; });
+        assert(!std::signbit(zeros.max()));
+    }
+
+    my_vector<std::string> s = {"a", "b"};
+    my_vector<std::string> t = {"a", "c"};
+    assert(s < t && (s <=> t) == std::strong_ordering::less && t.find("c") == t.begin() + 1);
+    my_vector<LessOnly> l = {{1}, {2}};
+    my_vector<LessOnly> m = {{1}, {3}};
+    assert((l <=> m) == std::weak_ordering::less && m > l);
+    static_assert(!std::three_way_comparable<my_vector<BadAssign>>);
+}
+
+struct ParallelBomb {
+    ParallelBomb(int value = 0) : value(value) {
+        alive++;
+    }
+
+    ParallelBomb(const ParallelBomb& a) : value(a.value) {
+        if (--countdown == 0) {
+            throw std::runtime_error("Boom");
+        }
+        alive++;
+    }
+
+    ~ParallelBomb() {
+        alive--;
+    }
+
+    int value;
+    static std::atomic<int> countdown;
+    static std::atomic<int> alive;
+};
+
+std::atomic<int> ParallelBomb::countdown = -1;
+std::atomic<int> ParallelBomb::alive = 0;
+
+void test_parallel() {
+    thread_pool pool(4);
+    parallel_policy policy{&pool, 0};
+
+    my_vector<int> a(policy, 1001, 7);
+    assert(a.size() == 1001 && a.count(7) == 1001);
+    my_vector<int> b(policy, a);
+    assert(a == b);
+    b.assign(policy, 10, 3);
+    assert(b == my_vector<int>(10, 3));
+
+    my_vector<std::string> s(policy, 100, "x");
+    parallel_for_each(policy, s, [](std::string& str) { str += "y"; });
+    my_vector<std::string> t(policy, s);
+    assert(t == my_vector<std::string>(100, "xy"));
+
+    my_vector<size_t> lengths;
+    parallel_transform(policy, t, lengths, [](const std::string& str) { return str.size(); });
+    assert(lengths == my_vector<size_t>(100, 2));
+
+    std::atomic<size_t> sum = 0;
+    pool.for_chunks(100, [&](size_t first, size_t last) {
+        pool.for_chunks(last - first, [&](size_t from, size_t to) { sum += to - from; });
+    });
+    assert(sum == 100);
+
+    {
+        my_vector<ParallelBomb> c(policy, 50, ParallelBomb(1));
+        ParallelBomb::countdown = 30;
+        bool catched = false;
+        try {
+            my_vector<ParallelBomb> d(policy, c);
+        } catch (std::runtime_error&) {
+            catched = true;
+        }
+        assert(catched && ParallelBomb::alive == 50);
+        ParallelBomb::countdown = -1;
+    }
+    assert(ParallelBomb::alive == 0);
+
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> serial = true;
+    parallel_for_each(par, a, [&](int&) {
+        serial = serial && std::this_thread::get_id() == caller;
+    });
+    assert(serial);
+}
+
+void test_soa_vector() {
+    soa_vector<int, std::string, double> a;
+    a.push_back({1, "one", 1.5});
+    auto [id, name, weight] = a.emplace_back(2, "two", 2.5);
+    assert(id == 2 && name == "two" && weight == 2.5);
+    name += "!";
+    std::tuple<int, std::string, double> third(3, "three", 3.5);
+    a.push_back(third);
+    assert(a.size() == 3 && std::get<1>(a[1]) == "two!");
+
+    a[0] = std::tuple(10, "ten", 10.5);
+    std::get<2>(a.back()) = 4.5;
+    std::tuple<int, std::string, double> copy = a.front();
+    assert(copy == std::tuple(10, "ten", 10.5));
+
+    std::span<int> ids = a.column<0>();
+    assert(ids.size() == 3 && ids[0] == 10 && ids[2] == 3);
+    std::span<const double> weights = std::as_const(a).column<2>();
+    assert(weights[2] == 4.5);
+
+    static_assert(std::random_access_iterator<soa_vector<int, double>::iterator>);
+    int sum = 0;
+    for (auto [i, s, w] : a) {
+        sum += i;
+        s += "?";
+    }
+    assert(sum == 15 && std::get<1>(a[2]) == "three?");
+    auto it = a.begin() + 1;
+    soa_vector<int, std::string, double>::const_iterator cit = it;
+    assert(cit - a.begin() == 1 && std::get<0>(*cit) == 2 && std::get<0>(it[1]) == 3);
+    assert(a.end() - a.begin() == 3 && it < a.end());
+
+    soa_vector<int, std::string, double> b = a;
+    assert(a == b);
+    b.pop_back();
+    assert(a != b && b.size() == 2);
+    b.resize(5);
+    assert(b.size() == 5 && std::get<1>(b[4]).empty() && b.column<0>().size() == 5);
+    b.swap(a);
+    assert(a.size() == 5 && b.size() == 3);
+
+    soa_vector<int, CopyBomb> c;
+    c.reserve(4);
+    c.emplace_back(1, CopyBomb(1));
+    CopyBomb bomb(2);
+    CopyBomb::countdown = 1;
+    bool catched = false;
+    try {
+        c.emplace_back(2, bomb);
+    } catch (std::runtime_error&) {
+        catched = true;
+    }
+    assert(catched && c.size() == 1 && c.column<0>().size() == 1);
+    CopyBomb::countdown = 0;
+
+    alignas(double) char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                              std::pmr::null_memory_resource());
+    basic_soa_vector<std::pmr::polymorphic_allocator<std::byte>, geometric_growth<3, 2>, int,
+                     double>
+        d(&arena);
+    for (int i = 0; i < 20; ++i) {
+        d.emplace_back(i, i * 0.5);
+    }
+    assert(d.get_allocator().resource() == &arena && std::get<1>(d[19]) == 9.5);
+    assert(reinterpret_cast<char*>(d.column<1>().data()) >= buffer);
+    assert(reinterpret_cast<char*>(d.column<1>().data()) < buffer + sizeof(buffer));
+    my_vector<int, std::allocator<int>, geometric_growth<3, 2>> growth;
+    for (int i = 0; i < 20; ++i) {
+        growth.push_back(i);
+    }
+    assert(d.capacity() == growth.capacity());
+}
+
+void test_concurrent_vector() {
+    concurrent_vector<long long> a;
+    const long long threads = 4;
+    const long long per_thread = 50'000;
+    std::atomic<bool> stable = true;
+    my_vector<std::thread> producers;
+    for (long long t = 0; t < threads; ++t) {
+        producers.emplace_back([&, t] {
+            long long* first = &a.push_back(t << 32);
+            for (long long i = 1; i < per_thread; ++i) {
+                long long val = (t << 32) | i;
+                long long& elem = i % 2 ? a.emplace_back(val) : a.push_back(val);
+                assert(elem == val);
+            }
+            stable = stable && *first == t << 32;
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    assert(stable && a.size() == threads * per_thread);
+
+    my_vector<long long> next(threads, 0);
+    for (long long x : a) {
+        assert((x & 0xffffffff) == next[x >> 32]++);
+    }
+    assert(next == my_vector<long long>(threads, per_thread));
+
+    concurrent_vector<std::string> b;
+    b.reserve(100);
+    std::string* front = &b.push_back("front");
+    size_t first = b.grow_by(5000, "x");
+    assert(first == 1 && b.size() == 5001 && b[5000] == "x" && &b[0] == front);
+    assert(b.end() - b.begin() == 5001 && *std::as_const(b).begin() == "front");
+    bool catched = false;
+    try {
+        b.at(5001);
+    } catch (std::out_of_range&) {
+        catched = true;
+    }
+    assert(catched);
+    b.clear();
+    assert(b.empty());
+
+    {
+        concurrent_vector<ParallelBomb> c;
+        c.grow_by(10, ParallelBomb(1));
+        ParallelBomb::countdown = 3;
+        catched = false;
+        try {
+            c.grow_by(10, ParallelBomb(2));
+        } catch (std::runtime_error&) {
+            catched = true;
+        }
+        ParallelBomb::countdown = 1;
+        try {
+            c.push_back(ParallelBomb(3));
+        } catch (std::runtime_error&) {
+        }
+        ParallelBomb::countdown = -1;
+        c.emplace_back(4);
+        assert(catched && c.size() == 22 && ParallelBomb::alive == 13 && c[21].value == 4);
+    }
+    assert(ParallelBomb::alive == 0);
+}
+
+#ifdef MY_VECTOR_INSTRUMENT
+size_t hook_reallocations = 0;
+size_t hook_bytes_moved = 0;
+size_t hook_clears = 0;
+
+void count_events(const vector_event_info& info) {
+    if (info.event == vector_event::reallocate) {
+        hook_reallocations++;
+        hook_bytes_moved += info.bytes_moved;
+    } else if (info.event == vector_event::clear) {
+        hook_clears++;
+    }
+}
+#endif
+
+void test_instrumentation() {
+#ifdef MY_VECTOR_INSTRUMENT
+    vector_instrument& global = vector_instrument::global();
+    global.reset();
+    global.set_hook(count_events);
+    {
+        my_vector<int> a;
+        for (int i = 0; i < 100; ++i) {
+            a.push_back(i);
+        }
+        // Capacities 1, 2, 4, ..., 128: eight allocations, seven of them reallocations.
+        const vector_stats& stats = a.stats();
+        assert(stats.allocations == 8 && stats.deallocations == 7 && stats.reallocations == 7);
+        assert(stats.bytes_moved == (1 + 2 + 4 + 8 + 16 + 32 + 64) * sizeof(int));
+        assert(stats.constructions == 100 && stats.peak_capacity == 128);
+        assert(hook_reallocations == 7 && hook_bytes_moved == stats.bytes_moved);
+
+        my_vector<std::string> b(10, "x");
+        my_vector<std::string> c = b;
+        assert(c.stats().allocations == 1 && c.stats().constructions == 10);
+        c.clear();
+        assert(hook_clears == 1 && c.stats().deallocations == 1);
+
+        my_vector<int> d;
+        d.reserve(3);
+        d.push_back(1);
+        assert(d.stats().reallocations == 0 && d.stats().allocations == 1);
+    }
+    assert(global.allocations == global.deallocations && global.reallocations == 7);
+    assert(global.peak_capacity_bytes == std::max(128 * sizeof(int), 10 * sizeof(std::string)));
+
+    std::FILE* out = std::tmpfile();
+    global.dump_histogram(out);
+    std::rewind(out);
+    char line[128];
+    std::string dump;
+    while (std::fgets(line, sizeof(line), out) != nullptr) {
+        dump += line;
+    }
+    std::fclose(out);
+    assert(dump.find("64..127") != std::string::npos && dump.find("8..15") != std::string::npos);
+
+    // Elements built aside or with placement new are counted like the others.
+    my_vector<int> d;
+    d.reserve(3);
+    d.push_back(1);
+    d.insert(d.begin(), 0);
+    d.emplace(d.begin() + 1, 2);
+    assert(d.stats().constructions == 3);
+    d.emplace(d.begin() + 1, 3);
+    assert(d.stats().constructions == 4 && d.stats().reallocations == 1);
+    d.resize_default_init(10);
+    assert(d.stats().constructions == 10);
+    my_vector<std::string> e(2, "x");
+    e.reserve(8);
+    size_t before = e.stats().constructions;
+    e.resize_default_init(5);
+    e.emplace(e.begin() + 1, "y");
+    assert(e.stats().constructions == before + 4);
+    global.set_hook(nullptr);
+#endif
+}
+
 int main() {
 
     test_constructor_copy_swap_clear();
@@ -313,7 +2081,33 @@ int main() {
     test_insert_emplace_erase();
     test_iterators();
     test_lifetime();
+    test_uninitialized_resize();
     test_insert_erase_safety();
+    test_copy_rollback();
+    test_move_on_growth();
+    test_trivially_relocatable();
+    test_stateful_allocator();
+    test_arena_pool();
+    test_small_vector();
+    test_growth_policy();
+    test_mmap_allocator();
+    test_huge_page_allocator();
+    test_mmap_vector();
+    test_serialization();
+    test_cow_vector();
+    test_cow_vector_allocators();
+    test_persistent_vector();
+    test_iterator_checks();
+    test_iterator_conformance();
+    test_element_access();
+    test_error_handling();
+    test_forwarding();
+    test_bulk_operations();
+    test_simd_operations();
+    test_parallel();
+    test_soa_vector();
+    test_concurrent_vector();
+    test_instrumentation();
 
     std::cout << "All tests passed" << std::endl;
     return 0;
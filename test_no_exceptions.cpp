@@ -0,0 +1,89 @@
+// Built with -fno-exceptions: my_vector has to compile without throw and try, and report
+// allocation failure through the try_ functions.
+#include "Vector.h"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+
+static_assert(!vector_exceptions);
+
+// Reports failure by returning nullptr for buffers of more than 1000 elements.
+template <class T>
+struct limited_allocator : std::allocator<T> {
+    template <class U>
+    struct rebind {
+        using other = limited_allocator<U>;
+    };
+
+    T* allocate(size_t n) {
+        return n > 1000 ? nullptr : std::allocator<T>::allocate(n);
+    }
+};
+
+void test_basic_operations() {
+    my_vector<std::string> a = {"b", "c"};
+    a.insert(a.begin(), "a");
+    a.emplace_back(3, 'd');
+    a.push_back(a[0]);
+    assert(a.size() == 5 && a[0] == "a" && a[3] == "ddd" && a.back() == "a");
+
+    a.erase(a.begin() + 1);
+    a.erase(a.begin(), a.begin() + 2);
+    assert(a.size() == 2 && a[0] == "ddd");
+
+    my_vector<std::string> b = a;
+    b.resize(10);
+    b.pop_back();
+    assert(b.size() == 9 && b[1] == "a" && a == my_vector<std::string>({"ddd", "a"}));
+
+    my_vector<int> c(1000, 7);
+    c.insert(c.begin() + 10, 5, 1);
+    assert(c.size() == 1005 && c.count(1) == 5 && c.max() == 7);
+}
+
+// Failures abort, so mutators are noexcept as far as T's operations are.
+void test_noexcept() {
+    my_vector<int> a;
+    static_assert(noexcept(a.push_back(1)) && noexcept(a.emplace_back()));
+    static_assert(noexcept(a.insert(a.cbegin(), 1)) && noexcept(a.insert(a.cbegin(), 2, 1)));
+    static_assert(noexcept(a.reserve(1)) && noexcept(a.resize(1)));
+    static_assert(noexcept(a.try_push_back(1)) && noexcept(a.try_reserve(1)));
+
+    my_vector<std::string> b;
+    static_assert(noexcept(b.push_back(std::string())) && noexcept(b.resize(1)));
+    static_assert(!noexcept(b.push_back(b[0])) && !noexcept(b.emplace_back("x")));
+}
+
+void test_try_functions() {
+    my_vector<int> a;
+    assert(a.try_reserve(16) == vector_status::ok && a.capacity() == 16);
+    assert(a.try_reserve(std::numeric_limits<size_t>::max()) == vector_status::length_error);
+    assert(a.capacity() == 16 && a.empty());
+
+    my_vector<int, limited_allocator<int>> limited(10, 1);
+    assert(limited.try_reserve(1001) == vector_status::out_of_memory);
+    assert(limited.try_push_back(2) == vector_status::ok && limited.capacity() == 20);
+    limited.resize(1000);
+    assert(limited.try_push_back(3) == vector_status::out_of_memory && limited.size() == 1000);
+
+    for (int i = 0; i < 1000; ++i) {
+        assert(a.try_push_back(i) == vector_status::ok);
+    }
+    assert(a.size() == 1000 && a[999] == 999);
+
+    my_vector<std::string> b;
+    assert(b.try_emplace_back("x") == vector_status::ok);
+    assert(b.try_push_back(b[0]) == vector_status::ok);
+    assert(b.size() == 2 && b[1] == "x");
+}
+
+int main() {
+    test_basic_operations();
+    test_noexcept();
+    test_try_functions();
+
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}